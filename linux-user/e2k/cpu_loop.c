@@ -23,6 +23,92 @@
 #include "cpu_loop-common.h"
 #include "target_elf.h"
 
+static abi_ulong e2k_syscall(CPUE2KState *env)
+{
+    abi_ullong args[E2K_SYSCALL_MAX_ARGS] = { 0 };
+    int psize = MIN(E2K_SYSCALL_MAX_ARGS, env->wd.size);
+    int i;
+
+    // TODO: check what happens if env->wd.size is zero
+    for (i = 0; i < psize; i++) {
+        args[i] = env->regs[e2k_wr_index(env, i)].lo;
+    }
+
+    /* mmap, munmap, mprotect, etc may invalidate cached page probes */
+    e2k_sm_flush(env);
+
+    return do_syscall(env, args[0], args[1], args[2], args[3],
+        args[4], args[5], args[6], args[7], args[8]);
+}
+
+static void e2k_syscall_ret(CPUE2KState *env, abi_ulong ret)
+{
+    int psize = MIN(E2K_SYSCALL_MAX_ARGS, env->wd.size);
+    int i;
+
+    for (i = 0; i < psize; i++) {
+        env->tags[e2k_wr_index(env, i)] = E2K_TAG_NON_NUMBER64;
+    }
+
+    env->regs[e2k_wr_index(env, 0)].lo = ret;
+    env->tags[e2k_wr_index(env, 0)] = E2K_TAG_NUMBER64;
+}
+
+/*
+ * Syscalls which do not change the process or signal state and can be
+ * executed without leaving cpu_exec(). The ones which may block are only
+ * allowed while there are no other threads, because a blocked CPU which is
+ * still running would stall their exclusive sections.
+ */
+static bool e2k_syscall_is_direct(abi_ulong nr, bool *may_block)
+{
+    switch (nr) {
+    case TARGET_NR_read:
+    case TARGET_NR_write:
+    case TARGET_NR_readv:
+    case TARGET_NR_writev:
+    case TARGET_NR_pread64:
+    case TARGET_NR_pwrite64:
+        *may_block = true;
+        return true;
+    case TARGET_NR_lseek:
+    case TARGET_NR_fstat:
+    case TARGET_NR_getpid:
+    case TARGET_NR_gettid:
+    case TARGET_NR_gettimeofday:
+    case TARGET_NR_clock_gettime:
+        *may_block = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool e2k_cpu_syscall_direct(CPUE2KState *env)
+{
+    CPUState *cs = env_cpu(env);
+    TaskState *ts = cs->opaque;
+    abi_ulong nr = env->regs[e2k_wr_index(env, 0)].lo;
+    abi_ulong ret;
+    bool may_block;
+
+    if (env->wd.size == 0 || env->wd.psize == 0 ||
+        !e2k_syscall_is_direct(nr, &may_block) ||
+        (may_block && CPU_NEXT(first_cpu) != NULL) ||
+        qatomic_read(&ts->signal_pending)) {
+        return false;
+    }
+
+    ret = e2k_syscall(env);
+    if (ret == -TARGET_ERESTARTSYS) {
+        /* interrupted by a signal, restart it from cpu_loop() */
+        return false;
+    }
+
+    e2k_syscall_ret(env, ret);
+    return true;
+}
+
 void cpu_loop(CPUE2KState *env)
 {
     CPUState *cs = env_cpu(env);
@@ -37,24 +123,12 @@ void cpu_loop(CPUE2KState *env)
 
         switch (trapnr) {
         case E2K_EXCP_SYSCALL: {
-            abi_ullong args[E2K_SYSCALL_MAX_ARGS] = { 0 };
-            int psize = MIN(E2K_SYSCALL_MAX_ARGS, env->wd.size);
-            abi_ulong ret;
-
-            // TODO: check what happens if env->wd.size is zero
-            memcpy(args, env->regs, psize * sizeof(args[0]));
-
-            ret = do_syscall(env, args[0], args[1], args[2], args[3],
-                args[4], args[5], args[6], args[7], args[8]);
+            abi_ulong ret = e2k_syscall(env);
 
             if (ret == -TARGET_ERESTARTSYS) {
                 /* do not set sysret address and syscall will be restarted */
             } else if (ret != -TARGET_QEMU_ESIGRETURN && env->wd.psize > 0) {
-                memset(env->tags, E2K_TAG_NON_NUMBER64,
-                    psize * sizeof(env->tags[0]));
-
-                env->regs[0] = ret;
-                env->tags[0] = E2K_TAG_NUMBER64;
+                e2k_syscall_ret(env, ret);
                 env->ip = E2K_SYSRET_ADDR;
             }
             break;
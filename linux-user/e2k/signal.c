@@ -112,7 +112,7 @@ struct target_sigframe {
 
 #define NF_ALIGNEDSZ  (((sizeof(struct target_signal_frame) + 7) & (~7)))
 
-void helper_signal_frame(CPUE2KState *env, int wbs, target_ulong ret_ip);
+bool helper_signal_frame(CPUE2KState *env, int wbs, target_ulong ret_ip);
 void helper_signal_return(CPUE2KState *env);
 
 static abi_long setup_sigcontext(CPUE2KState *env,
@@ -194,7 +194,12 @@ static void target_setup_frame(int sig, struct target_sigaction *ka,
     struct target_sigframe *frame;
 
     /* save current frame */
-    helper_signal_frame(env, env->wd.size, env->ip);
+    if (!helper_signal_frame(env, env->wd.size, env->ip)) {
+        /* the hardware stacks are full */
+        force_sigsegv(sig);
+        return;
+    }
+    e2k_psp_flush(env);
 
     frame_addr = get_sigframe(ka, env, sizeof(*frame));
     trace_user_setup_rt_frame(env, frame_addr);
@@ -215,25 +220,27 @@ static void target_setup_frame(int sig, struct target_sigaction *ka,
     }
 
     /* fake kernel frame */
-    env->regs[0] = frame_addr;
-    env->tags[0] = E2K_TAG_NUMBER64;
+    env->regs[e2k_wr_index(env, 0)].lo = frame_addr;
+    env->tags[e2k_wr_index(env, 0)] = E2K_TAG_NUMBER64;
     env->wd.size = 2;
     env->wd.psize = 0;
     env->usd.size = env->sbr - frame_addr;
     env->usd.base = frame_addr;
-    helper_signal_frame(env, 2, E2K_SYSRET_ADDR_CTPR);
+    if (!helper_signal_frame(env, 2, E2K_SYSRET_ADDR_CTPR)) {
+        goto fail;
+    }
 
     env->ip = ka->_sa_handler;
-    env->regs[0] = sig;
-    env->tags[0] = E2K_TAG_NUMBER64;
+    env->regs[e2k_wr_index(env, 0)].lo = sig;
+    env->tags[e2k_wr_index(env, 0)] = E2K_TAG_NUMBER64;
     env->wd.size = 8;
 
     if (info && (ka->sa_flags & TARGET_SA_SIGINFO)) {
         tswap_siginfo(&frame->info, info);
-        env->regs[1] = (uint64_t) &frame->info;
-        env->tags[1] = E2K_TAG_NUMBER64;
-        env->regs[2] = (uint64_t) &frame->uc;
-        env->tags[2] = E2K_TAG_NUMBER64;
+        env->regs[e2k_wr_index(env, 1)].lo = (uint64_t) &frame->info;
+        env->tags[e2k_wr_index(env, 1)] = E2K_TAG_NUMBER64;
+        env->regs[e2k_wr_index(env, 2)].lo = (uint64_t) &frame->uc;
+        env->tags[e2k_wr_index(env, 2)] = E2K_TAG_NUMBER64;
     }
 
     unlock_user_struct(frame, frame_addr, 1);
@@ -291,7 +298,7 @@ long do_rt_sigreturn(CPUE2KState *env)
 
     /* restore fake kernel frame */
     helper_signal_return(env);
-    frame_addr = env->regs[0];
+    frame_addr = env->regs[e2k_wr_index(env, 0)].lo;
 
     trace_user_do_rt_sigreturn(env, frame_addr);
     if (!lock_user_struct(VERIFY_READ, frame, frame_addr, 1)) {
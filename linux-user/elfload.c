@@ -1525,36 +1525,58 @@ static void elf_core_copy_regs(target_elf_gregset_t *regs,
 typedef target_elf_greg_t target_elf_gregset_t[ELF_NREG];
 #define USE_ELF_CORE_DUMP
 
-static abi_ulong e2k_mmap(abi_ulong size)
+/*
+ * Reserves max bytes for a hardware stack and commits the first size bytes.
+ * Everything above the committed part is inaccessible and acts as a guard.
+ */
+static abi_ulong e2k_mmap(abi_ulong size, abi_ulong max)
 {
     abi_ulong addr;
-    abi_ulong guard = TARGET_PAGE_SIZE;
 
-    if (size < TARGET_PAGE_SIZE) {
-        size = TARGET_PAGE_SIZE;
-    }
-    if (guard < qemu_real_host_page_size) {
-        guard = qemu_real_host_page_size;
-    }
+    size = TARGET_PAGE_ALIGN(size);
+    max = TARGET_PAGE_ALIGN(max);
 
-    addr = target_mmap(0, size + guard, PROT_READ | PROT_WRITE,
-        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    addr = target_mmap(0, max, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
     if (addr == -1) {
         perror("mmap e2k stack");
         exit(-1);
     }
 
-    target_mprotect(addr + size, guard, PROT_NONE);
+    if (target_mprotect(addr, size, PROT_READ | PROT_WRITE) != 0) {
+        perror("mprotect e2k stack");
+        exit(-1);
+    }
+
     return addr;
 }
 
+/* Moves the end of the committed part of a hardware stack from old to size. */
+static bool e2k_mresize(abi_ulong addr, abi_ulong old, abi_ulong size)
+{
+    old = TARGET_PAGE_ALIGN(old);
+    size = TARGET_PAGE_ALIGN(size);
+
+    if (size > old) {
+        return target_mprotect(addr + old, size - old,
+            PROT_READ | PROT_WRITE) == 0;
+    } else if (size < old) {
+        /* drop the pages instead of only protecting them */
+        return target_mmap(addr + size, old - size, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED,
+            -1, 0) != -1;
+    }
+
+    return true;
+}
+
 void e2k_pcs_new(E2KPcsState *pcs)
 {
     pcs->is_readable = true;
     pcs->is_writable = true;
     pcs->index = 0;
     pcs->size = E2K_DEFAULT_PCS_SIZE;
-    pcs->base = e2k_mmap(pcs->size);
+    pcs->base = e2k_mmap(pcs->size, E2K_MAX_PCS_SIZE);
 }
 
 void e2k_ps_new(E2KPsState *ps)
@@ -1563,8 +1585,29 @@ void e2k_ps_new(E2KPsState *ps)
     ps->is_writable = true;
     ps->index = 0;
     ps->size = E2K_DEFAULT_PS_SIZE;
-    ps->base = e2k_mmap(ps->size);
-    ps->base_tag = e2k_mmap(ps->size / 8);
+    ps->base = e2k_mmap(ps->size, E2K_MAX_PS_SIZE);
+    ps->base_tag = e2k_mmap(ps->size / 8, E2K_MAX_PS_SIZE / 8);
+}
+
+bool e2k_pcs_resize(E2KPcsState *pcs, target_ulong size)
+{
+    if (size > E2K_MAX_PCS_SIZE || !e2k_mresize(pcs->base, pcs->size, size)) {
+        return false;
+    }
+
+    pcs->size = size;
+    return true;
+}
+
+bool e2k_ps_resize(E2KPsState *ps, target_ulong size)
+{
+    if (size > E2K_MAX_PS_SIZE || !e2k_mresize(ps->base, ps->size, size) ||
+        !e2k_mresize(ps->base_tag, ps->size / 8, size / 8)) {
+        return false;
+    }
+
+    ps->size = size;
+    return true;
 }
 
 static inline void init_thread(struct target_pt_regs *regs, struct image_info *infop)
@@ -6903,6 +6903,8 @@ static abi_long do_e2k_longjmp2(CPUE2KState *env, struct target_jmp_info *jmp_in
     int ret, i;
     target_ulong pcsp = env->pcsp.base + env->pcsp.index;
 
+    e2k_psp_flush(env);
+
     jmp_pcsp.lo = jmp_info->pcsplo;
     jmp_pcsp.hi = jmp_info->pcsphi;
 
@@ -42,6 +42,7 @@ static void e2k_cpu_reset(DeviceState *dev)
     ecc->parent_reset(dev);
 
     memset(env, 0, offsetof(CPUE2KState, end_reset_fields));
+    e2k_sm_flush(env);
 
     env->wd.base = 0;
     env->wd.size = 16;
@@ -147,7 +148,7 @@ void e2k_cpu_dump_state(CPUState *cs, FILE *f, int flags)
     unsigned int i;
 
     qemu_fprintf(f, "       ip = 0x%016lx\n", env->ip);
-    qemu_fprintf(f, "    pregs = 0x%016lx\n", env->pregs);
+    qemu_fprintf(f, "    pregs = 0x%016lx\n", e2k_state_pregs(env));
     qemu_fprintf(f, "  pcsp_lo = 0x%016lx\n", e2k_state_pcsp_lo(env));
     qemu_fprintf(f, "  pcsp_hi = 0x%016lx\n", e2k_state_pcsp_hi(env));
     qemu_fprintf(f, "   psp_lo = 0x%016lx\n", e2k_state_psp_lo(env));
@@ -157,15 +158,17 @@ void e2k_cpu_dump_state(CPUState *cs, FILE *f, int flags)
     qemu_fprintf(f, "      lsr = 0x%016lx\n", env->lsr);
     cpu_dump_state_br(env, f, flags);
 
-    for (i = 0; i < E2K_REG_COUNT; i++) {
+    for (i = 0; i < E2K_NR_COUNT + E2K_GR_COUNT; i++) {
         char name = i < E2K_NR_COUNT ? 'r' : 'g';
-        int tag = env->tags[i];
-        qemu_fprintf(f, "%%%c%d\t<%d%d> 0x%lx\n", name, i, tag >> 2, tag & 3,
-            env->regs[i]);
+        int n = i < E2K_NR_COUNT ? i : i - E2K_NR_COUNT;
+        int r = i < E2K_NR_COUNT ? e2k_wr_index(env, n) : E2K_GR_BASE + n;
+        int tag = env->tags[r];
+        qemu_fprintf(f, "%%%c%d\t<%d%d> 0x%lx\n", name, n, tag >> 2, tag & 3,
+            env->regs[r].lo);
     }
 
     for (i = 0; i < 32; i++) {
-        int preg = (env->pregs >> (i * 2)) & 3;
+        int preg = env->pregs[i] & 3;
         qemu_fprintf(f, "pred%d\t<%d> %s\n", i, preg >> 1,
             preg & 1 ? "true" : "false");
     }
@@ -35,6 +35,9 @@ void e2k_tcg_initialize(void);
 #define CPU_RESOLVING_TYPE TYPE_E2K_CPU
 #define E2K_DEFAULT_PCS_SIZE (TARGET_PAGE_SIZE * 4)
 #define E2K_DEFAULT_PS_SIZE (TARGET_PAGE_SIZE * 16)
+/* address space reserved for the hardware stacks, committed on demand */
+#define E2K_MAX_PCS_SIZE (TARGET_PAGE_SIZE * 0x4000)
+#define E2K_MAX_PS_SIZE (TARGET_PAGE_SIZE * 0x10000)
 
 #define E2K_TAG_SIZE 2 /* 2-bit tag for 32-bit value */
 #define E2K_REG_LEN sizeof(uint64_t)
@@ -46,11 +49,37 @@ void e2k_tcg_initialize(void);
 #define E2K_NR_COUNT (E2K_WR_COUNT + E2K_BR_COUNT)
 #define E2K_GR_COUNT 32     /* %gN      [0, 32) */
 #define E2K_BGR_COUNT 8     /* %gN      [24, 32) */
-#define E2K_REG_COUNT (E2K_NR_COUNT + E2K_GR_COUNT)
-#define E2K_TLS_REG (E2K_NR_COUNT + 13)
+/*
+ * Physical register file. The current window starts at wd.base and caller
+ * windows are kept below it until they are spilled to the procedure stack.
+ * A window never crosses the end of the file, so %rN is at wd.base + N.
+ */
+#define E2K_PHYS_NR_COUNT 1024
+#define E2K_WD_MAX 256      /* wsz is 7 bits wide */
+#define E2K_REG_COUNT (E2K_PHYS_NR_COUNT + E2K_GR_COUNT)
+#define E2K_GR_BASE E2K_PHYS_NR_COUNT
+#define E2K_TLS_REG (E2K_GR_BASE + 13)
 
 #define E2K_PR_COUNT 32     /* %predN   [0, 32) */
 
+/*
+ * TB cs_base layout. Window and rotation parameters are static between
+ * procedure calls, so they are keyed into the TB and the translator can
+ * resolve register window bounds checks at translation time.
+ */
+#define E2K_TB_WD_SIZE_OFF 0    /* wd.size */
+#define E2K_TB_WD_SIZE_LEN 9
+#define E2K_TB_BOFF_OFF 16      /* bn.base */
+#define E2K_TB_BOFF_LEN 8
+#define E2K_TB_BSIZE_OFF 24     /* bn.size */
+#define E2K_TB_BSIZE_LEN 9
+#define E2K_TB_PSIZE_OFF 40     /* bp.size */
+#define E2K_TB_PSIZE_LEN 5
+#define E2K_TB_TAGS_OFF 48      /* tags_full */
+#define E2K_TB_TAGS_LEN 1
+#define E2K_TB_LOOP_KERNEL_OFF 49 /* e2k_loop_kernel() */
+#define E2K_TB_LOOP_KERNEL_LEN 1
+
 typedef enum {
     E2K_TAG_NUMBER32 = 0,
     E2K_TAG_NUMBER64 = 0,
@@ -383,7 +412,7 @@ typedef struct {
 } E2KStackState, E2KPsState, E2KPcsState;
 
 typedef struct {
-    int32_t base;
+    int32_t base; /* physical index of %r0 */
     uint32_t size;
     uint32_t psize;
     bool fx;
@@ -498,7 +527,6 @@ typedef struct {
     E2KAauPrefInstr pi;     /* prefetch instr */
     uint32_t cdi;   /* current data index */
     uint32_t ldi;   /* loaded data index */
-    target_ulong last_page;
 } E2KAauAreaState;
 
 typedef struct {
@@ -617,6 +645,13 @@ typedef union {
     uint64_t raw;
 } E2KDamEntry;
 
+/* Location loaded with a lock, see helper_dam_lock_addr */
+typedef struct {
+    target_ulong addr;
+    uint64_t value;
+    uint32_t size; /* zero if unused */
+} E2KDamLock;
+
 typedef union {
     uint32_t u32;
     uint64_t u64;
@@ -631,25 +666,41 @@ typedef union {
     int64_t i64v[2];
 } E2KReg;
 
+/*
+ * Both halves of a register are kept next to each other, so a v5+ quad
+ * register is a single 16-byte access.
+ */
+typedef struct {
+    uint64_t lo;
+    uint64_t hi; /* FX sign/exponent or the upper half of a quad register */
+} QEMU_ALIGNED(16) E2KQReg;
+
 typedef struct {
     /* register file */
     uint8_t tags[E2K_REG_COUNT]; /* registers tags */
-    uint64_t regs[E2K_REG_COUNT]; /* low parts of registers */
-    uint64_t xregs[E2K_REG_COUNT]; /* high parts of registers */
-    uint64_t pregs; /* predicate file */
+    E2KQReg regs[E2K_REG_COUNT];
+    /* predicate file, bit 0 is the value and bit 1 is the tag */
+    uint8_t pregs[32];
     target_ulong ip; /* instruction address */
 
     /* temporaries for FX/SIMD ops */
     E2KReg t0, t1, t2, t3;
+    /* v5+ quad results of each channel until the end of the bundle */
+    E2KQReg al_q[6];
+    /* sign and exponent of the last floatx80 helper result */
+    uint16_t fx_hi;
 
     /* DAM */
     E2KDamEntry dam[32];
+    E2KDamLock dam_lock[32];
 
     /* Procedure chain info = cr0_lo, cr0_hi, cr1_lo, cr1_hi */
     E2KPcsState pcsp;
 
     /* Procedure stack pointer (for regs)  */
     E2KPsState psp;
+    /* caller window registers still held in the register file */
+    uint32_t pshtp;
 
     E2KWdState wd;
     E2KBnState bn;
@@ -688,10 +739,22 @@ typedef struct {
 
     /* internal use */
     uint32_t is_bp; /* breakpoint flag */
+    /*
+     * The next TB must propagate register tags. Set when a TB translated
+     * without tag tracking reads a non-numeric register.
+     */
+    uint32_t tags_full;
 
     /* zeroing upper register half for 32-bit instructions */
     uint32_t wdbl;
 
+    /*
+     * pages last probed successfully by speculative loads and stores,
+     * single threaded processes only (see helper_sm.c)
+     */
+    target_ulong sm_rpage;
+    target_ulong sm_wpage;
+
     /* Fields up to this point are cleared by a CPU reset */
     struct {} end_reset_fields;
 
@@ -717,11 +780,32 @@ struct E2KCPU {
     CPUE2KState env;
 };
 
+/*
+ * Steady state of a software pipelined loop: the prologue is over and the
+ * loop cannot end in the next iteration, so stores are not masked and
+ * the loop counters cannot saturate.
+ */
+static inline bool e2k_loop_kernel(CPUE2KState *env)
+{
+    return env->lsr_pcnt == 0 && env->lsr_lcnt >= 2;
+}
+
 static inline void cpu_get_tb_cpu_state(CPUE2KState *env, target_ulong *pc,
                                         target_ulong *cs_base, uint32_t *pflags)
 {
+    uint64_t flags = 0;
+
+    flags = deposit64(flags, E2K_TB_WD_SIZE_OFF, E2K_TB_WD_SIZE_LEN,
+        env->wd.size);
+    flags = deposit64(flags, E2K_TB_BOFF_OFF, E2K_TB_BOFF_LEN, env->bn.base);
+    flags = deposit64(flags, E2K_TB_BSIZE_OFF, E2K_TB_BSIZE_LEN, env->bn.size);
+    flags = deposit64(flags, E2K_TB_PSIZE_OFF, E2K_TB_PSIZE_LEN, env->bp.size);
+    flags = deposit64(flags, E2K_TB_TAGS_OFF, E2K_TB_TAGS_LEN, env->tags_full);
+    flags = deposit64(flags, E2K_TB_LOOP_KERNEL_OFF, E2K_TB_LOOP_KERNEL_LEN,
+        e2k_loop_kernel(env));
+
     *pc = env->ip;
-    *cs_base = 0;
+    *cs_base = flags;
     *pflags = MMU_USER_IDX;
 }
 
@@ -734,8 +818,16 @@ bool e2k_cpu_tlb_fill(CPUState *cpu, vaddr address, int size,
                  MMUAccessType access_type, int mmu_idx,
                  bool probe, uintptr_t retaddr);
 void e2k_update_fp_status(CPUE2KState *env);
+void e2k_update_fp_flags(CPUE2KState *env);
 void e2k_pcs_new(E2KPcsState *pcs);
 void e2k_ps_new(E2KPsState *ps);
+bool e2k_pcs_resize(E2KPcsState *pcs, target_ulong size);
+bool e2k_ps_resize(E2KPsState *ps, target_ulong size);
+void e2k_psp_flush(CPUE2KState *env);
+#ifdef CONFIG_USER_ONLY
+/* linux-user/e2k/cpu_loop.c */
+bool e2k_cpu_syscall_direct(CPUE2KState *env);
+#endif
 
 #define cpu_signal_handler e2k_cpu_signal_handler
 #define cpu_list e2k_cpu_list
@@ -767,6 +859,20 @@ static inline uint64_t e2k_state_desc_hi(E2KStackState *env)
 #define e2k_state_psp_lo(env) e2k_state_desc_lo(&(env)->psp)
 #define e2k_state_psp_hi(env) e2k_state_desc_hi(&(env)->psp)
 
+/* Must be called whenever page protections may have changed. */
+static inline void e2k_sm_flush(CPUE2KState *env)
+{
+    /* never equal to a page address */
+    env->sm_rpage = -1;
+    env->sm_wpage = -1;
+}
+
+/* Physical register file index of %rN in the current window. */
+static inline int e2k_wr_index(CPUE2KState *env, int n)
+{
+    return env->wd.base + n;
+}
+
 static inline uint64_t e2k_state_wd(CPUE2KState *env)
 {
     E2KWdState *wd = &env->wd;
@@ -802,6 +908,38 @@ static inline uint32_t e2k_state_br(CPUE2KState *env)
     return ret;
 }
 
+/* Packs the predicate file into the CR0_LO format, 2 bits per predicate. */
+static inline uint64_t e2k_state_pregs(CPUE2KState *env)
+{
+    uint64_t ret = 0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        uint64_t x = ldq_le_p(&env->pregs[i * 8]) & 0x0303030303030303ULL;
+
+        x = (x | x >> 6) & 0x000f000f000f000fULL;
+        x = (x | x >> 12) & 0x000000ff000000ffULL;
+        x = (x | x >> 24) & 0xffff;
+        ret |= x << (i * 16);
+    }
+
+    return ret;
+}
+
+static inline void e2k_state_pregs_set(CPUE2KState *env, uint64_t pregs)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        uint64_t x = extract64(pregs, i * 16, 16);
+
+        x = (x | x << 24) & 0x000000ff000000ffULL;
+        x = (x | x << 12) & 0x000f000f000f000fULL;
+        x = (x | x << 6) & 0x0303030303030303ULL;
+        stq_le_p(&env->pregs[i * 8], x);
+    }
+}
+
 static inline void e2k_state_br_set(CPUE2KState *env, uint32_t br)
 {
     E2KBnState *bn = &env->bn;
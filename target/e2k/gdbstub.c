@@ -47,7 +47,7 @@ int e2k_cpu_gdb_read_register(CPUState *cs, GByteArray *mem_buf, int n)
     }
 
     if (3 <= n && n < 35) {
-        return gdb_get_reg64(mem_buf, env->regs[E2K_NR_COUNT + n - 3]);
+        return gdb_get_reg64(mem_buf, env->regs[E2K_GR_BASE + n - 3].lo);
     }
     
     switch (n) {
@@ -65,10 +65,14 @@ int e2k_cpu_gdb_read_register(CPUState *cs, GByteArray *mem_buf, int n)
     case 46: return gdb_get_reg64(mem_buf, 0); // usbr
     case 47: return gdb_get_reg64(mem_buf, env->usd.lo); // usd_lo
     case 48: return gdb_get_reg64(mem_buf, env->usd.hi); // usd_hi
-    case 49: return gdb_get_reg64(mem_buf, e2k_state_psp_lo(env)); // psp_lo
-    case 50: return gdb_get_reg64(mem_buf, e2k_state_psp_hi(env)); // psp_hi
+    case 49: /* psp_lo */
+        e2k_psp_flush(env);
+        return gdb_get_reg64(mem_buf, e2k_state_psp_lo(env));
+    case 50: /* psp_hi */
+        e2k_psp_flush(env);
+        return gdb_get_reg64(mem_buf, e2k_state_psp_hi(env));
     case 51: return gdb_get_reg64(mem_buf, 0); // pshtp
-    case 52: return gdb_get_reg64(mem_buf, env->pregs); // pregs
+    case 52: return gdb_get_reg64(mem_buf, e2k_state_pregs(env)); // pregs
     case 53: return gdb_get_reg64(mem_buf, env->ip); // ip
     case 54: { // cr1_lo
         uint64_t cr1_lo = cr_read(cs, env, offsetof(E2KCrs, cr1.lo));
@@ -8,7 +8,7 @@
 
 #define PS_FORCE_FX true
 
-void helper_signal_frame(CPUE2KState *env, int wbs, target_ulong ret_ip);
+bool helper_signal_frame(CPUE2KState *env, int wbs, target_ulong ret_ip);
 
 static inline void reset_ctprs(CPUE2KState *env)
 {
@@ -19,90 +19,287 @@ static inline void reset_ctprs(CPUE2KState *env)
     }
 }
 
-static inline void stack_push(CPUE2KState *env, E2KStackState *s, uint64_t value)
+/*
+ * Caller windows stay in the physical register file until it overflows.
+ * env->pshtp counts the registers below wd.base which still belong to the
+ * caller frames, psp.index accounts for them as if they were spilled.
+ * The procedure stack layout relies on E2K_FORCE_FX, so every register
+ * pair takes four entries: two values followed by two high halves.
+ */
+#define PS_PAIR_SIZE (E2K_REG_LEN * 4)
+#define PS_REG_SIZE (PS_PAIR_SIZE / 2)
+
+static inline void ps_write(CPUE2KState *env, target_ulong index,
+    uint64_t value, uint8_t tag)
 {
-    if ((s->index + 8) > s->size) {
-        helper_raise_exception(env, E2K_EXCP_MAPERR);
-        return;
+    cpu_stb_data(env, env->psp.base_tag + index / 8, tag);
+    cpu_stq_le_data(env, env->psp.base + index, value);
+}
+
+static inline uint64_t ps_read(CPUE2KState *env, target_ulong index,
+    uint8_t *tag)
+{
+    if (tag != NULL) {
+        *tag = cpu_ldub_data(env, env->psp.base_tag + index / 8);
     }
+    return cpu_ldq_le_data(env, env->psp.base + index);
+}
 
-    cpu_stq_le_data_ra(env, s->base + s->index, value, GETPC());
-    s->index += 8;
+/*
+ * Returns how many of the given register pairs at index can be accessed
+ * through a single host pointer for the values and another one for the
+ * tags, i.e. without crossing a page boundary in either range.
+ */
+static int ps_run(CPUE2KState *env, target_ulong index, int pairs)
+{
+    target_ulong addr = env->psp.base + index;
+    target_ulong tag_addr = env->psp.base_tag + index / 8;
+    int room = -(addr | TARGET_PAGE_MASK) / PS_PAIR_SIZE;
+    int tag_room = -(tag_addr | TARGET_PAGE_MASK) / (PS_PAIR_SIZE / 8);
+
+    return MIN(pairs, MIN(room, tag_room));
 }
 
-static inline uint64_t stack_pop(CPUE2KState *env, E2KStackState *s)
+static void ps_spill_slow(CPUE2KState *env, target_ulong index, int r)
 {
-    if (s->index < 8) {
-        helper_raise_exception(env, E2K_EXCP_MAPERR);
-        return 0;
+    ps_write(env, index, env->regs[r].lo, env->tags[r]);
+    ps_write(env, index + 8, env->regs[r + 1].lo, env->tags[r + 1]);
+    ps_write(env, index + 16, env->regs[r].hi, 0);
+    ps_write(env, index + 24, env->regs[r + 1].hi, 0);
+}
+
+static void ps_fill_slow(CPUE2KState *env, target_ulong index, int r)
+{
+    env->regs[r].lo = ps_read(env, index, &env->tags[r]);
+    env->regs[r + 1].lo = ps_read(env, index + 8, &env->tags[r + 1]);
+    env->regs[r].hi = ps_read(env, index + 16, NULL);
+    env->regs[r + 1].hi = ps_read(env, index + 24, NULL);
+}
+
+/* Writes the n oldest resident registers to the procedure stack. */
+static void ps_spill(CPUE2KState *env, int n)
+{
+    int resident = env->pshtp;
+    target_ulong index = env->psp.index - resident * PS_REG_SIZE;
+    int r = e2k_wr_index(env, -resident);
+    int pairs = n / 2;
+
+    while (pairs > 0) {
+        int i, len = ps_run(env, index, pairs);
+        uint8_t *v, *t;
+
+        if (len == 0) {
+            /* the pair crosses a page boundary */
+            ps_spill_slow(env, index, r);
+            index += PS_PAIR_SIZE;
+            r += 2;
+            pairs--;
+            continue;
+        }
+
+        v = probe_access(env, env->psp.base + index, len * PS_PAIR_SIZE,
+            MMU_DATA_STORE, MMU_USER_IDX, 0);
+        t = probe_access(env, env->psp.base_tag + index / 8,
+            len * PS_PAIR_SIZE / 8, MMU_DATA_STORE, MMU_USER_IDX, 0);
+
+        for (i = 0; i < len; i++, r += 2) {
+            stq_le_p(v, env->regs[r].lo);
+            stq_le_p(v + 8, env->regs[r + 1].lo);
+            stq_le_p(v + 16, env->regs[r].hi);
+            stq_le_p(v + 24, env->regs[r + 1].hi);
+            stl_le_p(t, env->tags[r] | (env->tags[r + 1] << 8));
+            v += PS_PAIR_SIZE;
+            t += PS_PAIR_SIZE / 8;
+        }
+
+        index += len * PS_PAIR_SIZE;
+        pairs -= len;
     }
 
-    s->index -= 8;
-    return cpu_ldq_le_data(env, s->base + s->index);
+    env->pshtp -= n;
 }
 
-static inline void ps_push(CPUE2KState *env, uint64_t value, uint8_t tag)
+/* Reloads n registers right below the resident ones. */
+static void ps_fill(CPUE2KState *env, int n)
 {
-    cpu_stb_data(env, env->psp.base_tag + env->psp.index / 8, tag);
-    stack_push(env, &env->psp, value);
+    int resident = env->pshtp;
+    target_ulong index = env->psp.index - (resident + n) * PS_REG_SIZE;
+    int r = e2k_wr_index(env, -resident - n);
+    int pairs = n / 2;
+
+    while (pairs > 0) {
+        int i, len = ps_run(env, index, pairs);
+        uint8_t *v, *t;
+
+        if (len == 0) {
+            /* the pair crosses a page boundary */
+            ps_fill_slow(env, index, r);
+            index += PS_PAIR_SIZE;
+            r += 2;
+            pairs--;
+            continue;
+        }
+
+        v = probe_access(env, env->psp.base + index, len * PS_PAIR_SIZE,
+            MMU_DATA_LOAD, MMU_USER_IDX, 0);
+        t = probe_access(env, env->psp.base_tag + index / 8,
+            len * PS_PAIR_SIZE / 8, MMU_DATA_LOAD, MMU_USER_IDX, 0);
+
+        for (i = 0; i < len; i++, r += 2) {
+            env->regs[r].lo = ldq_le_p(v);
+            env->regs[r + 1].lo = ldq_le_p(v + 8);
+            env->regs[r].hi = ldq_le_p(v + 16);
+            env->regs[r + 1].hi = ldq_le_p(v + 24);
+            env->tags[r] = t[0];
+            env->tags[r + 1] = t[1];
+            v += PS_PAIR_SIZE;
+            t += PS_PAIR_SIZE / 8;
+        }
+
+        index += len * PS_PAIR_SIZE;
+        pairs -= len;
+    }
+
+    env->pshtp += n;
 }
 
-static inline uint64_t ps_pop(CPUE2KState *env, uint8_t *ret_tag)
+/* Keeps room for a window of any size above the resident registers. */
+static void ps_reserve(CPUE2KState *env)
 {
-    uint64_t ret = stack_pop(env, &env->psp);
-    if (ret_tag != NULL) {
-        *ret_tag = cpu_ldub_data(env, env->psp.base_tag + env->psp.index / 8);
+    int n = env->pshtp + E2K_WD_MAX - E2K_PHYS_NR_COUNT;
+
+    if (n > 0) {
+        ps_spill(env, ROUND_UP(n, 2));
     }
-    return ret;
 }
 
-static void ps_spill(CPUE2KState *env, int n, bool fx)
+/*
+ * Moves the resident registers together with the current window so that
+ * %r0 ends up at new_base. Keeps windows from crossing the end of the file.
+ */
+static void ps_move(CPUE2KState *env, int new_base)
 {
-    int i;
-    for (i = 0; i < n; i += 2) {
-        ps_push(env, env->regs[i], env->tags[i]);
-        ps_push(env, env->regs[i + 1], env->tags[i + 1]);
-        if (fx || E2K_FORCE_FX) {
-            ps_push(env, env->xregs[i + 0], 0);
-            ps_push(env, env->xregs[i + 1], 0);
-        }
+    int src = env->wd.base - env->pshtp;
+    int dst = new_base - env->pshtp;
+    int len = MIN(env->wd.base + E2K_WD_MAX, E2K_PHYS_NR_COUNT) - src;
+
+    memmove(&env->regs[dst], &env->regs[src], len * sizeof(env->regs[0]));
+    memmove(&env->tags[dst], &env->tags[src], len * sizeof(env->tags[0]));
+    env->wd.base = new_base;
+}
+
+/* Writes back all resident caller registers to guest memory. */
+void e2k_psp_flush(CPUE2KState *env)
+{
+    ps_spill(env, env->pshtp);
+}
+
+void HELPER(flushr)(CPUE2KState *env)
+{
+    e2k_psp_flush(env);
+}
+
+/*
+ * Hardware stacks double their committed size when used bytes do not fit
+ * and halve it when less than a quarter is used.
+ */
+static target_ulong stack_new_size(target_ulong size, target_ulong used,
+    target_ulong min, target_ulong max)
+{
+    while (used > size && size < max) {
+        size *= 2;
+    }
+    while (size > min && used < size / 4) {
+        size /= 2;
     }
+    return MIN(size, max);
 }
 
-static void ps_fill(CPUE2KState *env, int n, bool fx)
+static bool ps_resize(CPUE2KState *env, target_ulong used)
 {
-    int i;
-    for (i = n; i > 0; i -= 2) {
-        if (fx || E2K_FORCE_FX) {
-            env->xregs[i - 1] = ps_pop(env, NULL);
-            env->xregs[i - 2] = ps_pop(env, NULL);
+    target_ulong size = stack_new_size(env->psp.size, used,
+        E2K_DEFAULT_PS_SIZE, E2K_MAX_PS_SIZE);
+
+    if (size != env->psp.size) {
+        if (!e2k_ps_resize(&env->psp, size)) {
+            return used <= env->psp.size;
         }
-        env->regs[i - 1] = ps_pop(env, &env->tags[i - 1]);
-        env->regs[i - 2] = ps_pop(env, &env->tags[i - 2]);
+        /* a shrink may have remapped a page cached for sm accesses */
+        e2k_sm_flush(env);
     }
+    return used <= size;
 }
 
-static void move_regs(CPUE2KState *env, int dst, int src, int n)
+static bool pcs_resize(CPUE2KState *env, target_ulong used)
 {
-    memmove(&env->regs[dst], &env->regs[src], n * sizeof(env->regs[0]));
-    memmove(&env->tags[dst], &env->tags[src], n * sizeof(env->tags[0]));
-    memmove(&env->xregs[dst], &env->xregs[src], n * sizeof(env->xregs[0]));
+    target_ulong size = stack_new_size(env->pcsp.size, used,
+        E2K_DEFAULT_PCS_SIZE, E2K_MAX_PCS_SIZE);
+
+    if (size != env->pcsp.size) {
+        if (!e2k_pcs_resize(&env->pcsp, size)) {
+            return used <= env->pcsp.size;
+        }
+        /* a shrink may have remapped a page cached for sm accesses */
+        e2k_sm_flush(env);
+    }
+    return used <= size;
 }
 
-static void callee_window(CPUE2KState *env, int base, int size, bool fx)
+static void callee_window(CPUE2KState *env, int base)
 {
-    ps_spill(env, base, fx);
-    move_regs(env, 0, base, size - base);
+    env->psp.index += base * PS_REG_SIZE;
+    env->pshtp += base;
+    env->wd.base += base;
+    ps_reserve(env);
+
+    if (env->wd.base + E2K_WD_MAX > E2K_PHYS_NR_COUNT) {
+        ps_move(env, env->pshtp);
+    }
 }
 
-static void caller_window(CPUE2KState *env, int base, int params, bool fx)
+static void caller_window(CPUE2KState *env, int base)
 {
-    move_regs(env, base, 0, params);
-    ps_fill(env, base, fx);
+    if (env->psp.index < base * PS_REG_SIZE) {
+        helper_raise_exception(env, E2K_EXCP_MAPERR);
+        return;
+    }
+
+    if (env->pshtp < base) {
+        int n = base - env->pshtp;
+
+        if (env->wd.base - env->pshtp < n) {
+            /* base is at most 254, leave room for calls above as well */
+            ps_move(env, (E2K_PHYS_NR_COUNT - E2K_WD_MAX) / 2);
+        }
+        ps_fill(env, n);
+    }
+
+    env->pshtp -= base;
+    env->psp.index -= base * PS_REG_SIZE;
+    env->wd.base -= base;
+    ps_resize(env, env->psp.index);
 }
 
+/*
+ * A frame never crosses a page boundary, so it can be accessed through a
+ * single host pointer once the page is known to be accessible. The guest
+ * accesses remain as the slow path which raises the fault.
+ */
 static void crs_write(CPUE2KState *env, target_ulong addr, E2KCrs *crs)
 {
+    void *host;
+    int flags;
+
+    flags = probe_access_flags(env, addr, MMU_DATA_STORE, MMU_USER_IDX, true,
+        &host, 0);
+    if (!(flags & TLB_INVALID_MASK) && host != NULL) {
+        stq_le_p(host + offsetof(E2KCrs, cr0_lo), crs->cr0_lo);
+        stq_le_p(host + offsetof(E2KCrs, cr0_hi), crs->cr0_hi);
+        stq_le_p(host + offsetof(E2KCrs, cr1.lo), crs->cr1.lo);
+        stq_le_p(host + offsetof(E2KCrs, cr1.hi), crs->cr1.hi);
+        return;
+    }
+
     cpu_stq_le_data(env, addr + offsetof(E2KCrs, cr0_lo), crs->cr0_lo);
     cpu_stq_le_data(env, addr + offsetof(E2KCrs, cr0_hi), crs->cr0_hi);
     cpu_stq_le_data(env, addr + offsetof(E2KCrs, cr1.lo), crs->cr1.lo);
@@ -111,6 +308,19 @@ static void crs_write(CPUE2KState *env, target_ulong addr, E2KCrs *crs)
 
 static void crs_read(CPUE2KState *env, target_ulong addr, E2KCrs *crs)
 {
+    void *host;
+    int flags;
+
+    flags = probe_access_flags(env, addr, MMU_DATA_LOAD, MMU_USER_IDX, true,
+        &host, 0);
+    if (!(flags & TLB_INVALID_MASK) && host != NULL) {
+        crs->cr0_lo = ldq_le_p(host + offsetof(E2KCrs, cr0_lo));
+        crs->cr0_hi = ldq_le_p(host + offsetof(E2KCrs, cr0_hi));
+        crs->cr1.lo = ldq_le_p(host + offsetof(E2KCrs, cr1.lo));
+        crs->cr1.hi = ldq_le_p(host + offsetof(E2KCrs, cr1.hi));
+        return;
+    }
+
     crs->cr0_lo = cpu_ldq_le_data(env, addr + offsetof(E2KCrs, cr0_lo));
     crs->cr0_hi = cpu_ldq_le_data(env, addr + offsetof(E2KCrs, cr0_hi));
     crs->cr1.lo = cpu_ldq_le_data(env, addr + offsetof(E2KCrs, cr1.lo));
@@ -119,12 +329,6 @@ static void crs_read(CPUE2KState *env, target_ulong addr, E2KCrs *crs)
 
 static void pcs_push(CPUE2KState *env, E2KCrs *crs)
 {
-    if ((env->pcsp.index + sizeof(E2KCrs) * 2) > env->pcsp.size) {
-        // TODO: stack expand (switch to next stack)
-        qemu_log_mask(LOG_UNIMP, "e2k stack expand\n");
-        helper_raise_exception(env, E2K_EXCP_MAPERR);
-    }
-
     env->pcsp.index += sizeof(E2KCrs);
     crs_write(env, env->pcsp.base + env->pcsp.index, crs);
 }
@@ -138,15 +342,24 @@ static void pcs_pop(CPUE2KState *env, E2KCrs *crs)
         qemu_log_mask(LOG_UNIMP, "e2k stack shrink\n");
     } else {
         env->pcsp.index -= sizeof(E2KCrs);
+        pcs_resize(env, env->pcsp.index + sizeof(E2KCrs) * 2);
     }
 }
 
-static void proc_call(CPUE2KState *env, int base, target_ulong ret_ip,
-    bool force_fx)
+/*
+ * Returns false without pushing anything if either hardware stack cannot
+ * grow to fit the new frame.
+ */
+static bool proc_call(CPUE2KState *env, int base, target_ulong ret_ip)
 {
     E2KCrs crs;
 
-    crs.cr0_lo = env->pregs;
+    if (!pcs_resize(env, env->pcsp.index + sizeof(E2KCrs) * 2) ||
+        !ps_resize(env, env->psp.index + base * PS_REG_SIZE)) {
+        return false;
+    }
+
+    crs.cr0_lo = e2k_state_pregs(env);
     crs.cr0_hi = ret_ip & ~7;
     crs.cr1.wbs = base / 2;
     crs.cr1.wpsz = env->wd.psize / 2;
@@ -156,14 +369,15 @@ static void proc_call(CPUE2KState *env, int base, target_ulong ret_ip,
     crs.cr1.ussz = env->usd.size >> 4;
 
     pcs_push(env, &crs);
-    callee_window(env, base, env->wd.size, env->wd.fx || force_fx);
+    callee_window(env, base);
 
     env->wd.fx = true;
     env->wd.size -= base;
     env->wd.psize = env->wd.size;
+    return true;
 }
 
-static void proc_return(CPUE2KState *env, bool force_fx)
+static void proc_return(CPUE2KState *env)
 {
     E2KCrs crs;
     int base;
@@ -171,9 +385,9 @@ static void proc_return(CPUE2KState *env, bool force_fx)
     pcs_pop(env, &crs);
     base = crs.cr1.wbs * 2;
 
-    caller_window(env, base, env->wd.psize, crs.cr1.wfx || force_fx);
+    caller_window(env, base);
 
-    env->pregs = crs.cr0_lo;
+    e2k_state_pregs_set(env, crs.cr0_lo);
     env->ip = crs.cr0_hi & ~7;
     e2k_state_br_set(env, crs.cr1.br);
     env->wd.size = env->wd.psize + base;
@@ -184,25 +398,33 @@ static void proc_return(CPUE2KState *env, bool force_fx)
     env->usd.base = env->sbr - env->usd.size;
 }
 
-void HELPER(signal_frame)(CPUE2KState *env, int wd_size, target_ulong ret_ip)
+bool HELPER(signal_frame)(CPUE2KState *env, int wd_size, target_ulong ret_ip)
 {
-    proc_call(env, wd_size, ret_ip, false);
+    return proc_call(env, wd_size, ret_ip);
 }
 
 void HELPER(signal_return)(CPUE2KState *env)
 {
-    proc_return(env, false);
+    proc_return(env);
 }
 
 static inline void do_call(CPUE2KState *env, int wbs, target_ulong ret_ip)
 {
-    proc_call(env, wbs * 2, ret_ip, false);
+    if (!proc_call(env, wbs * 2, ret_ip)) {
+        helper_raise_exception_no_spill(env, E2K_EXCP_MAPERR);
+    }
     reset_ctprs(env);
 }
 
 void HELPER(syscall)(CPUE2KState *env)
 {
     CPUState *cs = env_cpu(env);
+
+    if (e2k_cpu_syscall_direct(env)) {
+        helper_sysret(env);
+        return;
+    }
+
     cs->exception_index = E2K_EXCP_SYSCALL;
     cpu_loop_exit(cs);
 }
@@ -250,8 +472,8 @@ void HELPER(return)(CPUE2KState *env)
     if (opc == CTPR_OPC_SIGRET) {
         CPUState *cs = env_cpu(env);
         env->wd.psize = 2;
-        env->regs[0] = 119; /* TARGET_NR_sigreturn */
-        env->tags[0] = E2K_TAG_NUMBER64;
+        env->regs[e2k_wr_index(env, 0)].lo = 119; /* TARGET_NR_sigreturn */
+        env->tags[e2k_wr_index(env, 0)] = E2K_TAG_NUMBER64;
         cs->exception_index = E2K_EXCP_SYSCALL;
         cpu_loop_exit(cs);
     } else {
@@ -259,16 +481,26 @@ void HELPER(return)(CPUE2KState *env)
             qemu_log("%#lx: unknown return ctpr opc %d\n", env->ip, opc);
         }
 
-        proc_return(env, false);
+        proc_return(env);
         reset_ctprs(env);
     }
 }
 
+/* Returns from the fake syscall handler. */
+void HELPER(sysret)(CPUE2KState *env)
+{
+    env->ctprs[2].raw = helper_prep_return(env, 0);
+    helper_return(env);
+}
+
 void HELPER(raise_exception)(CPUE2KState *env, int tt)
 {
     CPUState *cs = env_cpu(env);
     cs->exception_index = tt;
-    proc_call(env, env->wd.size, env->ip, true);
+    if (!proc_call(env, env->wd.size, env->ip)) {
+        /* no room left in the hardware stacks for the trap frame */
+        cs->exception_index = E2K_EXCP_MAPERR;
+    }
     cpu_loop_exit(cs);
 }
 
@@ -288,7 +520,7 @@ void HELPER(setwd)(CPUE2KState *env, int wsz, int nfx, int dbl)
     }
 
     for (i = env->wd.size; i < size; i++) {
-        env->tags[i] = E2K_TAG_NON_NUMBER64;
+        env->tags[e2k_wr_index(env, i)] = E2K_TAG_NON_NUMBER64;
     }
 
     env->wd.size = size;
@@ -302,7 +534,7 @@ bool e2k_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     E2KCPU *cpu = E2K_CPU(cs);
     CPUE2KState *env = &cpu->env;
 
-    proc_call(env, env->wd.size, env->ip, true);
+    proc_call(env, env->wd.size, env->ip);
 
     cs->exception_index = E2K_EXCP_MAPERR;
     cpu_loop_exit_restore(cs, retaddr);
@@ -310,7 +542,7 @@ bool e2k_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
 
 void HELPER(break_restore_state)(CPUE2KState *env)
 {
-    proc_return(env, true);
+    proc_return(env);
     env->is_bp = false;
 }
 
@@ -318,7 +550,7 @@ void HELPER(debug)(CPUE2KState *env)
 {
     CPUState *cs = env_cpu(env);
     env->is_bp = true;
-    proc_call(env, env->wd.size, env->ip, true);
+    proc_call(env, env->wd.size, env->ip);
     cs->exception_index = EXCP_DEBUG;
     cpu_loop_exit(cs);
 }
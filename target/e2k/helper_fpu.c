@@ -7,9 +7,21 @@
 
 #define glue3(x, y, z) glue(glue(x, y), z)
 #define glue4(x, y, z, w) glue(glue3(x, y, z), w)
-#define deref(x) *(x)
 #define no_cvt(x) (x) /* when in correct type */
 
+/*
+ * A floatx80 is passed to helpers as its 64-bit significand and 16-bit
+ * sign/exponent. A helper returns the significand of a floatx80 result and
+ * leaves the sign/exponent in env->fx_hi.
+ */
+#define f80_in(lo, hi) make_floatx80(hi, lo)
+
+static inline uint64_t f80_ret(CPUE2KState *env, floatx80 x)
+{
+    env->fx_hi = x.high;
+    return x.low;
+}
+
 static inline void fpu_set_exception(CPUE2KState *env, int mask)
 {
     env->fpsr.ef |= mask;
@@ -26,17 +38,55 @@ static inline int save_exception_flags(CPUE2KState *env)
     return old_flags;
 }
 
+static inline int fpu_flags_to_ef(int flags)
+{
+    return (flags & float_flag_invalid ? FPSR_IE : 0) |
+           (flags & float_flag_divbyzero ? FPSR_ZE : 0) |
+           (flags & float_flag_overflow ? FPSR_OE : 0) |
+           (flags & float_flag_underflow ? FPSR_UE : 0) |
+           (flags & float_flag_inexact ? FPSR_PE : 0) |
+           (flags & float_flag_input_denormal ? FPSR_DE : 0);
+}
+
 static inline void merge_exception_flags(CPUE2KState *env, int old_flags)
 {
     int new_flags = get_float_exception_flags(&env->fp_status);
     float_raise((uint8_t)old_flags, &env->fp_status);
-    fpu_set_exception(env,
-                      ((new_flags & float_flag_invalid ? FPSR_IE : 0) |
-                       (new_flags & float_flag_divbyzero ? FPSR_ZE : 0) |
-                       (new_flags & float_flag_overflow ? FPSR_OE : 0) |
-                       (new_flags & float_flag_underflow ? FPSR_UE : 0) |
-                       (new_flags & float_flag_inexact ? FPSR_PE : 0) |
-                       (new_flags & float_flag_input_denormal ? FPSR_DE : 0)));
+    fpu_set_exception(env, fpu_flags_to_ef(new_flags));
+}
+
+/*
+ * The exception flags in fp_status are sticky and mirror fpsr.ef, see
+ * e2k_update_fp_flags. If every exception is masked then there is nothing
+ * to report per operation, so the flags are left as they are and folded
+ * into fpsr afterwards. Keeping float_flag_inexact set lets softfloat use
+ * the host FPU, which checks for inexact and invalid results after the fact.
+ */
+static inline bool fpu_all_masked(CPUE2KState *env)
+{
+    return (env->fpcr.em & FPCR_EM) == FPCR_EM;
+}
+
+static inline void fpu_fold_flags(CPUE2KState *env, int old_flags)
+{
+    int new_flags = get_float_exception_flags(&env->fp_status);
+
+    if (unlikely(new_flags != old_flags)) {
+        env->fpsr.ef |= fpu_flags_to_ef(new_flags);
+    }
+}
+
+void e2k_update_fp_flags(CPUE2KState *env)
+{
+    int ef = env->fpsr.ef;
+
+    set_float_exception_flags(
+        (ef & FPSR_IE ? float_flag_invalid : 0) |
+        (ef & FPSR_ZE ? float_flag_divbyzero : 0) |
+        (ef & FPSR_OE ? float_flag_overflow : 0) |
+        (ef & FPSR_UE ? float_flag_underflow : 0) |
+        (ef & FPSR_PE ? float_flag_inexact : 0) |
+        (ef & FPSR_DE ? float_flag_input_denormal : 0), &env->fp_status);
 }
 
 void e2k_update_fp_status(CPUE2KState *env)
@@ -80,9 +130,17 @@ void e2k_update_fp_status(CPUE2KState *env)
 #define GENERATE_SIMPLE_FLOAT2_OP(name, function, size) \
     uint##size##_t HELPER(name)(CPUE2KState *env, uint##size##_t x, uint##size##_t y) \
     { \
-        int old_flags = save_exception_flags(env); \
-        float##size z = float##size##_##function (make_float##size (x), make_float##size (y), &env->fp_status); \
-        merge_exception_flags(env, old_flags); \
+        int old_flags; \
+        float##size z; \
+        if (likely(fpu_all_masked(env))) { \
+            old_flags = get_float_exception_flags(&env->fp_status); \
+            z = float##size##_##function (make_float##size (x), make_float##size (y), &env->fp_status); \
+            fpu_fold_flags(env, old_flags); \
+        } else { \
+            old_flags = save_exception_flags(env); \
+            z = float##size##_##function (make_float##size (x), make_float##size (y), &env->fp_status); \
+            merge_exception_flags(env, old_flags); \
+        } \
         return float##size##_val(z); \
     }
 
@@ -99,10 +157,20 @@ void e2k_update_fp_status(CPUE2KState *env)
         return z ? -1 : 0; \
     }
 
+#define GENERATE_CMP_FLOATX80_OP(name, expr, op) \
+    uint64_t HELPER(name)(CPUE2KState *env, uint64_t xl, uint32_t xh, \
+                          uint64_t yl, uint32_t yh) \
+    { \
+        int old_flags = save_exception_flags(env); \
+        uint64_t z = expr op(f80_in(xl, xh), f80_in(yl, yh), &env->fp_status); \
+        merge_exception_flags(env, old_flags); \
+        return z ? -1 : 0; \
+    }
+
 #define GENERATE_CMP_FLOAT2_OPS_32_64_80(name, expr, op) \
     GENERATE_CMP_FLOAT2_OP(uint32_t, glue3(f, name, s), expr, glue(float32_, op), uint32_t, make_float32) \
     GENERATE_CMP_FLOAT2_OP(uint64_t, glue3(f, name, d), expr, glue(float64_, op), uint64_t, make_float32) \
-    GENERATE_CMP_FLOAT2_OP(uint64_t, glue3(fx, name, x), expr, glue(floatx80_, op), floatx80*, deref)
+    GENERATE_CMP_FLOATX80_OP(glue3(fx, name, x), expr, glue(floatx80_, op))
 
 #define GENERATE_CVT_FLOAT1_OP(name, from_t, to_t, size_from, size_to, func_from, func_to) \
     size_to HELPER(name)(CPUE2KState *env, size_from x) \
@@ -113,6 +181,15 @@ void e2k_update_fp_status(CPUE2KState *env)
         return z; \
     }
 
+#define GENERATE_CVT_FLOATX80_OP(name, to_t, size_to, func_to) \
+    size_to HELPER(name)(CPUE2KState *env, uint64_t lo, uint32_t hi) \
+    { \
+        int old_flags = save_exception_flags(env); \
+        size_to z = func_to( glue(floatx80_to_, to_t) (f80_in(lo, hi), &env->fp_status) ); \
+        merge_exception_flags(env, old_flags); \
+        return z; \
+    }
+
 GENERATE_SIMPLE_FLOAT2_OPS_32_64(fadd, add)
 GENERATE_SIMPLE_FLOAT2_OPS_32_64(fsub, sub)
 GENERATE_SIMPLE_FLOAT2_OPS_32_64(fmin, min)
@@ -146,48 +223,55 @@ GENERATE_CVT_FLOAT1_OP(fdtois,   float64, int32,   uint64_t, uint32_t, make_floa
 GENERATE_CVT_FLOAT1_OP(idtofs,   int64,   float32, uint64_t, uint32_t, no_cvt, float32_val)
 GENERATE_CVT_FLOAT1_OP(fdtoistr, float64, int32_round_to_zero, uint64_t, uint32_t, make_float64, no_cvt)
 
-GENERATE_CVT_FLOAT1_OP(fxtofs,   floatx80, float32, floatx80*, uint32_t, deref, float32_val)
-GENERATE_CVT_FLOAT1_OP(fxtois,   floatx80, int32, floatx80*, uint32_t, deref, no_cvt)
-GENERATE_CVT_FLOAT1_OP(fxtoistr, floatx80, int32_round_to_zero, floatx80*, uint32_t, deref, no_cvt)
+GENERATE_CVT_FLOATX80_OP(fxtofs,   float32, uint32_t, float32_val)
+GENERATE_CVT_FLOATX80_OP(fxtois,   int32, uint32_t, no_cvt)
+GENERATE_CVT_FLOATX80_OP(fxtoistr, int32_round_to_zero, uint32_t, no_cvt)
 
-GENERATE_CVT_FLOAT1_OP(fxtofd,   floatx80, float64, floatx80*, uint64_t, deref, float64_val)
-GENERATE_CVT_FLOAT1_OP(fxtoid,   floatx80, int64, floatx80*, uint64_t, deref, no_cvt)
-GENERATE_CVT_FLOAT1_OP(fxtoidtr, floatx80, int64_round_to_zero, floatx80*, uint64_t, deref, no_cvt)
+GENERATE_CVT_FLOATX80_OP(fxtofd,   float64, uint64_t, float64_val)
+GENERATE_CVT_FLOATX80_OP(fxtoid,   int64, uint64_t, no_cvt)
+GENERATE_CVT_FLOATX80_OP(fxtoidtr, int64_round_to_zero, uint64_t, no_cvt)
 
-void HELPER(fstofx)(floatx80 *ret, CPUE2KState *env, uint32_t x)
+uint64_t HELPER(fstofx)(CPUE2KState *env, uint32_t x)
 {
     int old_flags = save_exception_flags(env);
-    *ret = float32_to_floatx80(make_float32(x), &env->fp_status);
+    floatx80 z = float32_to_floatx80(make_float32(x), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
-void HELPER(fdtofx)(floatx80 *ret, CPUE2KState *env, uint64_t x)
+uint64_t HELPER(fdtofx)(CPUE2KState *env, uint64_t x)
 {
     int old_flags = save_exception_flags(env);
-    *ret = float64_to_floatx80(make_float64(x), &env->fp_status);
+    floatx80 z = float64_to_floatx80(make_float64(x), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
-void HELPER(istofx)(floatx80 *ret, CPUE2KState *env, uint32_t x)
+uint64_t HELPER(istofx)(CPUE2KState *env, uint32_t x)
 {
     int old_flags = save_exception_flags(env);
-    *ret = int32_to_floatx80(no_cvt(x), &env->fp_status);
+    floatx80 z = int32_to_floatx80(no_cvt(x), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
-void HELPER(idtofx)(floatx80 *ret, CPUE2KState *env, uint64_t x)
+uint64_t HELPER(idtofx)(CPUE2KState *env, uint64_t x)
 {
     int old_flags = save_exception_flags(env);
-    *ret = int64_to_floatx80(no_cvt(x), &env->fp_status);
+    floatx80 z = int64_to_floatx80(no_cvt(x), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
 #define GEN_OP2_XX(name, op) \
-    void HELPER(name)(CPUE2KState *env, floatx80 *x, floatx80 *y) \
+    uint64_t HELPER(name)(CPUE2KState *env, uint64_t xl, uint32_t xh, \
+                          uint64_t yl, uint32_t yh) \
     { \
         int old_flags = save_exception_flags(env); \
-        *x = glue(floatx80_, op)(*x, *y, &env->fp_status); \
+        floatx80 z = glue(floatx80_, op)(f80_in(xl, xh), f80_in(yl, yh), \
+                                         &env->fp_status); \
         merge_exception_flags(env, old_flags); \
+        return f80_ret(env, z); \
     }
 
 GEN_OP2_XX(fxaddxx, add)
@@ -195,20 +279,20 @@ GEN_OP2_XX(fxsubxx, sub)
 GEN_OP2_XX(fxmulxx, mul)
 GEN_OP2_XX(fxdivxx, div)
 
-void HELPER(fxrsubxx)(CPUE2KState *env, floatx80 *x, floatx80 *y)
+uint64_t HELPER(fxrsubxx)(CPUE2KState *env, uint64_t xl, uint32_t xh,
+                          uint64_t yl, uint32_t yh)
 {
     int old_flags = save_exception_flags(env);
-    *x = floatx80_sub(*y, *x, &env->fp_status);
+    floatx80 z = floatx80_sub(f80_in(yl, yh), f80_in(xl, xh), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
-#define GENERATE_FCMPODF(op, IN, F, cvt_macro) \
-    uint32_t HELPER(op)(CPUE2KState *env, IN _x, IN _y) \
+#define GENERATE_FCMPODF(F) \
+    static uint32_t glue(F, _cmpodf)(CPUE2KState *env, F x, F y) \
     { \
         int old_flags = save_exception_flags(env); \
         uint32_t ret; \
-        F x = cvt_macro(_x); \
-        F y = cvt_macro(_y); \
         if (glue(F, _is_any_nan)(x) || glue(F, _is_any_nan)(y)) { \
             ret = 0x45; \
         } else { \
@@ -233,9 +317,25 @@ void HELPER(fxrsubxx)(CPUE2KState *env, floatx80 *x, floatx80 *y)
         merge_exception_flags(env, old_flags); \
         return ret; \
     }
-GENERATE_FCMPODF(fcmpodsf,  uint32_t, float32, make_float32)
-GENERATE_FCMPODF(fcmpoddf,  uint64_t, float64, make_float64)
-GENERATE_FCMPODF(fxcmpodxf, floatx80 *, floatx80, deref)
+GENERATE_FCMPODF(float32)
+GENERATE_FCMPODF(float64)
+GENERATE_FCMPODF(floatx80)
+
+uint32_t HELPER(fcmpodsf)(CPUE2KState *env, uint32_t x, uint32_t y)
+{
+    return float32_cmpodf(env, make_float32(x), make_float32(y));
+}
+
+uint32_t HELPER(fcmpoddf)(CPUE2KState *env, uint64_t x, uint64_t y)
+{
+    return float64_cmpodf(env, make_float64(x), make_float64(y));
+}
+
+uint32_t HELPER(fxcmpodxf)(CPUE2KState *env, uint64_t xl, uint32_t xh,
+                           uint64_t yl, uint32_t yh)
+{
+    return floatx80_cmpodf(env, f80_in(xl, xh), f80_in(yl, yh));
+}
 
 /* didn't found any difference between these instruction
    so keep it that way for now */
@@ -249,9 +349,10 @@ uint32_t HELPER(fcmpuddf)(CPUE2KState *env, float64 x, float64 y)
     return HELPER(fcmpoddf)(env, x, y);
 }
 
-uint32_t HELPER(fxcmpudxf)(CPUE2KState *env, floatx80 *x, floatx80 *y)
+uint32_t HELPER(fxcmpudxf)(CPUE2KState *env, uint64_t xl, uint32_t xh,
+                           uint64_t yl, uint32_t yh)
 {
-    return HELPER(fxcmpodxf)(env, x, y);
+    return HELPER(fxcmpodxf)(env, xl, xh, yl, yh);
 }
 
 #define TOIF_RC_CURRENT        0x4
@@ -349,11 +450,13 @@ uint64_t HELPER(fsqrttd)(CPUE2KState *env, uint64_t x, uint64_t unused)
     return float64_val(y);
 }
 
-void HELPER(fxsqrttxx)(CPUE2KState *env, floatx80 *x, floatx80 *unused)
+uint64_t HELPER(fxsqrttxx)(CPUE2KState *env, uint64_t xl, uint32_t xh,
+                           uint64_t unused_lo, uint32_t unused_hi)
 {
     int old_flags = save_exception_flags(env);
-    *x = floatx80_sqrt(*x, &env->fp_status);
+    floatx80 z = floatx80_sqrt(f80_in(xl, xh), &env->fp_status);
     merge_exception_flags(env, old_flags);
+    return f80_ret(env, z);
 }
 
 #define IMPL_FSCALE(name, ty, exp_len, exp_off, mul, cvt) \
@@ -384,7 +487,8 @@ void HELPER(fxsqrttxx)(CPUE2KState *env, floatx80 *x, floatx80 *unused)
 IMPL_FSCALE(fscaled, uint64_t, 11, 52, helper_fmuld, uint64_to_float64)
 IMPL_FSCALE(fscales, uint32_t, 8, 23, helper_fmuls, uint32_to_float32)
 
-void HELPER(fxscalesx)(CPUE2KState *env, floatx80 *src1, uint32_t src2)
+uint64_t HELPER(fxscalesx)(CPUE2KState *env, uint64_t lo, uint32_t hi,
+                           uint32_t src2)
 {
     floatx80 s2;
     int32_t p = (int32_t) src2;
@@ -405,5 +509,5 @@ void HELPER(fxscalesx)(CPUE2KState *env, floatx80 *src1, uint32_t src2)
         s2.low = 1UL << 63;
         s2.high = bias + p;
     }
-    helper_fxmulxx(env, src1, &s2);
+    return helper_fxmulxx(env, lo, hi, s2.low, s2.high);
 }
@@ -39,6 +39,13 @@ uint64_t helper_state_reg_read_i64(CPUE2KState *env, int idx)
 {
     switch (idx) {
     case 0x01: return e2k_state_wd(env); /* %wd */
+    case 0x07: /* %psp.hi */
+        e2k_psp_flush(env);
+        return e2k_state_psp_hi(env);
+    case 0x09: /* %psp.lo */
+        e2k_psp_flush(env);
+        return e2k_state_psp_lo(env);
+    case 0x0b: return 0; /* %pshtp */
     case 0x0f: return e2k_state_pcsp_lo(env); /* %pcsp.lo */
     case 0x0d: return e2k_state_pcsp_hi(env); /* %pcsp.hi */
     case 0x13: return 0; /* %pcshtp */
@@ -99,7 +106,10 @@ void helper_state_reg_write_i64(CPUE2KState *env, int idx, uint64_t val)
         env->fpcr.raw = val;
         e2k_update_fp_status(env);
         break;
-    case 0x86: env->fpsr.raw = val; break; /* %fpsr */
+    case 0x86: /* %fpsr */
+        env->fpsr.raw = val;
+        e2k_update_fp_flags(env);
+        break;
     default:
         qemu_log_mask(LOG_UNIMP, "rwd unknown state register 0x%x\n", idx);
         break;
@@ -122,7 +132,10 @@ void helper_state_reg_write_i32(CPUE2KState *env, int idx, uint32_t val)
         env->fpcr.raw = val;
         e2k_update_fp_status(env);
         break;
-    case 0x86: env->fpsr.raw = val; break; /* %fpsr */
+    case 0x86: /* %fpsr */
+        env->fpsr.raw = val;
+        e2k_update_fp_flags(env);
+        break;
     default:
         qemu_log_mask(LOG_UNIMP, "rws unknown state register 0x%x\n", idx);
         break;
@@ -139,13 +152,32 @@ uint64_t helper_getsp(CPUE2KState *env, uint32_t src2)
     return env->usd.base;
 }
 
-void HELPER(dam_lock_addr)(CPUE2KState *env, uint64_t addr, int size, int reg)
+/*
+ * A check load must report a conflict (%MLOCK) if the location loaded
+ * earlier with a lock could have been changed by a store since then.
+ * Instead of tracking every store the locked value is compared with the
+ * current one. This also catches stores from other vCPUs without any
+ * synchronization between them, and stores which write the same value do
+ * not make the lock load result stale anyway.
+ */
+void HELPER(dam_lock_addr)(CPUE2KState *env, uint64_t addr, uint64_t value,
+    int size, int reg)
 {
-    // TODO: helper_dam_lock_addr
+    E2KDamLock *lock = &env->dam_lock[reg % ARRAY_SIZE(env->dam_lock)];
+
+    lock->addr = addr;
+    lock->value = value;
+    lock->size = size;
 }
 
-int HELPER(dam_unlock_addr)(CPUE2KState *env, uint64_t addr, int size, int reg)
+/* returns 1 if the lock was lost */
+int HELPER(dam_unlock_addr)(CPUE2KState *env, uint64_t addr, uint64_t value,
+    int size, int reg)
 {
-    // TODO: helper_dam_unlock_addr
-    return 1;
+    E2KDamLock *lock = &env->dam_lock[reg % ARRAY_SIZE(env->dam_lock)];
+    int ret = lock->size != size || lock->addr != addr || lock->value != value;
+
+    lock->size = 0;
+
+    return ret;
 }
@@ -6,14 +6,31 @@
 #include "exec/helper-proto.h"
 #include "translate.h"
 
+/*
+ * Another thread may unmap or protect a cached page without this CPU
+ * noticing, so the cache is only filled while the process has a single
+ * thread. It is flushed on every syscall, clone included, so a new thread
+ * starts from an empty one and stale entries from before it are dropped.
+ */
+static inline bool sm_can_cache(void)
+{
+    return CPU_NEXT(first_cpu) == NULL;
+}
+
 int HELPER(probe_read_access)(CPUE2KState *env, target_ulong addr)
 {
     int flags;
     void *ignore;
 
     flags = probe_access_flags(env, addr, MMU_DATA_LOAD, 0, true, &ignore, 0);
+    if (flags & TLB_INVALID_MASK) {
+        return 0;
+    }
 
-    return (flags & TLB_INVALID_MASK) == 0;
+    if (sm_can_cache()) {
+        env->sm_rpage = addr & TARGET_PAGE_MASK;
+    }
+    return 1;
 }
 
 int HELPER(probe_write_access)(CPUE2KState *env, target_ulong addr)
@@ -22,6 +39,12 @@ int HELPER(probe_write_access)(CPUE2KState *env, target_ulong addr)
     void *ignore;
 
     flags = probe_access_flags(env, addr, MMU_DATA_STORE, 0, true, &ignore, 0);
+    if (flags & TLB_INVALID_MASK) {
+        return 0;
+    }
 
-    return (flags & TLB_INVALID_MASK) == 0;
+    if (sm_can_cache()) {
+        env->sm_wpage = addr & TARGET_PAGE_MASK;
+    }
+    return 1;
 }
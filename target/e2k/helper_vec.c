@@ -6,14 +6,6 @@
 #include "exec/helper-proto.h"
 #include "translate.h"
 
-static uint8_t reverse_bits(uint8_t b)
-{
-    b = ((b & 0xf0) >> 4) | ((b & 0x0f) << 4);
-    b = ((b & 0xcc) >> 2) | ((b & 0x33) << 2);
-    b = ((b & 0xaa) >> 1) | ((b & 0x55) << 1);
-    return b;
-}
-
 #define vec64_ub 8
 #define vec64_uh 4
 #define vec64_uw 2
@@ -26,6 +18,10 @@ static uint8_t reverse_bits(uint8_t b)
 
 #define vec64_len(type) glue(vec64_, type)
 
+/* host vector types for packed float32 ops */
+typedef float vec64_fs __attribute__((vector_size(8)));
+typedef int32_t vec64_mask __attribute__((vector_size(8)));
+
 typedef union {
     uint8_t ub[vec64_ub];
     uint16_t uh[vec64_uh];
@@ -35,6 +31,8 @@ typedef union {
     int16_t sh[vec64_uh];
     int32_t sw[vec64_uw];
     int64_t sd[vec64_ud];
+    vec64_fs fs;
+    vec64_mask mask;
 } vec64;
 
 #define ident(x) x
@@ -68,65 +66,6 @@ typedef union {
     GEN_HELPER_PACKED_N(name, vec64_len(type), { \
         dst.type[i] = op(s1.type[i], s2.type[i]); \
     })
-#define GEN_HELPER_PACKED_SCALAR(name, type, code) \
-    uint64_t HELPER(name)(uint64_t src1, uint64_t s2) \
-    { \
-        size_t i = 0; \
-        vec64 s1 = { .ud[0] = src1 }, dst = { .ud[0] = 0 }; \
-        for (; i < glue(vec64_, type); i++) { \
-            code \
-        } \
-        return dst.ud[0]; \
-    }
-#define GEN_HELPER_PACKED_MINMAX(name, type, op) \
-    GEN_HELPER_PACKED(glue(name, type), type, { \
-        dst.type[i] = op(s1.type[i], s2.type[i]); \
-    })
-
-GEN_HELPER_PACKED_MINMAX(pmin, ub, MIN)
-GEN_HELPER_PACKED_MINMAX(pmin, sb, MIN)
-GEN_HELPER_PACKED_MINMAX(pmin, uh, MIN)
-GEN_HELPER_PACKED_MINMAX(pmin, sh, MIN)
-GEN_HELPER_PACKED_MINMAX(pmin, uw, MIN)
-GEN_HELPER_PACKED_MINMAX(pmin, sw, MIN)
-
-GEN_HELPER_PACKED_MINMAX(pmax, ub, MAX)
-GEN_HELPER_PACKED_MINMAX(pmax, sb, MAX)
-GEN_HELPER_PACKED_MINMAX(pmax, uh, MAX)
-GEN_HELPER_PACKED_MINMAX(pmax, sh, MAX)
-GEN_HELPER_PACKED_MINMAX(pmax, uw, MAX)
-GEN_HELPER_PACKED_MINMAX(pmax, sw, MAX)
-
-#define GEN_HELPER_PACKED_CMP(name, type, op) \
-    GEN_HELPER_PACKED(name, type, { \
-        dst.type[i] = s1.type[i] op s2.type[i] ? -1 : 0; \
-    })
-
-GEN_HELPER_PACKED_CMP(pcmpeqb, ub, ==)
-GEN_HELPER_PACKED_CMP(pcmpeqh, uh, ==)
-GEN_HELPER_PACKED_CMP(pcmpeqw, uw, ==)
-GEN_HELPER_PACKED_CMP(pcmpeqd, ud, ==)
-
-GEN_HELPER_PACKED_CMP(pcmpgtb, sb, >)
-GEN_HELPER_PACKED_CMP(pcmpgth, sh, >)
-GEN_HELPER_PACKED_CMP(pcmpgtw, sw, >)
-GEN_HELPER_PACKED_CMP(pcmpgtd, sd, >)
-
-#define GEN_HELPER_PACKED_BINOP_MAP(name, type, op, cast, map) \
-    GEN_HELPER_PACKED(name, type, { \
-        dst.type[i] = map((cast) s1.type[i] op s2.type[i]); \
-    })
-
-GEN_HELPER_PACKED_BINOP_MAP(paddsb,  sb, +, int16_t, satsb)
-GEN_HELPER_PACKED_BINOP_MAP(paddsh,  sh, +, int32_t, satsh)
-GEN_HELPER_PACKED_BINOP_MAP(paddusb, ub, +, int16_t, satub)
-GEN_HELPER_PACKED_BINOP_MAP(paddush, uh, +, int32_t, satuh)
-
-GEN_HELPER_PACKED_BINOP_MAP(psubsb,  sb, -, int16_t, satsb)
-GEN_HELPER_PACKED_BINOP_MAP(psubsh,  sh, -, int32_t, satsh)
-GEN_HELPER_PACKED_BINOP_MAP(psubusb, ub, -, int16_t, satub)
-GEN_HELPER_PACKED_BINOP_MAP(psubush, uh, -, int32_t, satuh)
-
 #define GEN_HELPER_PACKED_HORIZONTAL_OP(name, type, op, map) \
     GEN_HELPER_PACKED_N(name, vec64_len(type) / 2, { \
         int j = i * 2; \
@@ -141,24 +80,6 @@ GEN_HELPER_PACKED_HORIZONTAL_OP(phsubh,  sh, sub, ident)
 GEN_HELPER_PACKED_HORIZONTAL_OP(phsubw,  sw, sub, ident)
 GEN_HELPER_PACKED_HORIZONTAL_OP(phsubsh, sh, sub, satsh)
 
-#define GEN_HELPER_PACKED_SCALAR_BINOP(name, type, op) \
-    GEN_HELPER_PACKED_SCALAR(name, type, { \
-        dst.type[i] = s1.type[i] op s2; \
-    })
-
-GEN_HELPER_PACKED_SCALAR_BINOP(psllh, uh, <<)
-GEN_HELPER_PACKED_SCALAR_BINOP(psllw, uw, <<)
-GEN_HELPER_PACKED_SCALAR_BINOP(psrlh, uh, >>)
-GEN_HELPER_PACKED_SCALAR_BINOP(psrlw, uw, >>)
-
-#define GEN_HELPER_PACKED_SRA(name, type, t) \
-    GEN_HELPER_PACKED_SCALAR(name, type, { \
-        dst.type[i] = (t) s1.type[i] >> s2; \
-    })
-
-GEN_HELPER_PACKED_SRA(psrah, sh, int32_t)
-GEN_HELPER_PACKED_SRA(psraw, sw, int64_t)
-
 #define GEN_HELPER_PACKED_MAD(name, dst_type, type, cast, op) \
     GEN_HELPER_PACKED(name, dst_type, { \
         int j = i * 2; \
@@ -173,9 +94,6 @@ GEN_HELPER_PACKED_MAD(pmaddubsh, sh, ub, int16_t, satsh)
 
 GEN_HELPER_PACKED(psadbw, ub, { dst.uw[0] += s1.ub[i] - s2.ub[i]; })
 
-GEN_HELPER_PACKED(pavgusb, ub, { dst.ub[i] = (s1.ub[i] + s2.ub[i] + 1) >> 1; })
-GEN_HELPER_PACKED(pavgush, uh, { dst.uh[i] = (s1.uh[i] + s2.uh[i] + 1) >> 1; })
-
 #define GEN_HELPER_PACKED_MULH(name, type, cast, map) \
     GEN_HELPER_PACKED(name, type, { \
         dst.type[i] = map(((cast) s1.type[i]) * s2.type[i]); \
@@ -222,75 +140,130 @@ GEN_HELPER_PACKED(packushb, uh, PACK(ub, sh, satub))
 GEN_HELPER_PACKED(packsswh, sw, PACK(sh, sw, satsh))
 GEN_HELPER_PACKED(packuswh, sw, PACK(uh, sw, satuh))
 
-#define GEN_HELPER_PACKED_UNPACK(name, type, offset) \
-    GEN_HELPER_PACKED(name, type, { \
-        int j = offset + i / 2; \
-        dst.type[i] = i & 1 ? s1.type[j] : s2.type[j]; \
-    })
-
-GEN_HELPER_PACKED_UNPACK(punpcklbh, ub, 0)
-GEN_HELPER_PACKED_UNPACK(punpcklhw, uh, 0)
-GEN_HELPER_PACKED_UNPACK(punpcklwd, uw, 0)
-GEN_HELPER_PACKED_UNPACK(punpckhbh, ub, 4)
-GEN_HELPER_PACKED_UNPACK(punpckhhw, uh, 2)
-GEN_HELPER_PACKED_UNPACK(punpckhwd, uw, 1)
+/* Each byte of x, duplicated over the 8 bytes of a word. */
+#define BYTES(x) ((x) * 0x0101010101010101ULL)
 
-uint64_t HELPER(pshufb)(uint64_t src1, uint64_t src2, uint64_t src3)
+/* 0xff in the bytes of x that have the given bit set. */
+static inline uint64_t byte_mask(uint64_t x, int bit)
 {
-    vec64 ret, s1, s2, s3;
-    unsigned int i;
+    return ((x >> bit) & BYTES(1)) * 0xff;
+}
 
-    s1.ud[0] = src1;
-    s2.ud[0] = src2;
-    s3.ud[0] = src3;
+/*
+ * Every byte of src3 describes a byte of the result:
+ *   bits 2:0 index a byte, taken from src1 if bit 3 is set or else from src2
+ *   bits 6:5 are 1 to reverse its bits, 2 to repeat its msb or 3 its lsb
+ *   bit 4 inverts it
+ *   bit 7 makes a constant instead, 0x7f, 0x80 or 0xff for bits 6:5 equal
+ *   to 1, 2 or 3, zero otherwise
+ */
+static uint64_t pshufb_int(uint64_t src1, uint64_t src2, uint64_t src3)
+{
+    uint64_t byte = 0, rev, m5, m6, m7, ret;
+    int i;
 
     for (i = 0; i < 8; i++) {
-        uint8_t desc = s3.ub[i];
-        int index = extract8(desc, 0, 3);
-        uint8_t byte;
-
-        if (desc < 0x80) {
-            byte = desc & 0x08 ? s1.ub[index] : s2.ub[index];
-
-            switch(desc >> 5) {
-            case 0x1: byte = reverse_bits(byte); break;
-            case 0x2: byte = (byte & 0x80) != 0 ? 0xff : 0; break;
-            case 0x3: byte = (byte & 1) != 0 ? 0xff : 0; break;
-            default: break;
-            }
-
-            if (desc & 0x10) {
-                byte = ~byte;
-            }
-        } else {
-            switch(desc >> 6) {
-            case 0xa: byte = 0x7f; break;
-            case 0xc: byte = 0x80; break;
-            case 0xe: byte = 0xff; break;
-            default: byte = 0; break;
-            }
-        }
+        uint64_t desc = src3 >> (i * 8);
+        uint64_t src = desc & 8 ? src1 : src2;
 
-        ret.ub[i] = byte;
+        byte |= ((src >> ((desc & 7) * 8)) & 0xff) << (i * 8);
     }
 
-    return ret.ud[0];
+    rev = ((byte >> 4) & BYTES(0x0f)) | ((byte & BYTES(0x0f)) << 4);
+    rev = ((rev >> 2) & BYTES(0x33)) | ((rev & BYTES(0x33)) << 2);
+    rev = ((rev >> 1) & BYTES(0x55)) | ((rev & BYTES(0x55)) << 1);
+
+    m5 = byte_mask(src3, 5);
+    m6 = byte_mask(src3, 6);
+    m7 = byte_mask(src3, 7);
+    ret = (byte & ~(m5 | m6)) |
+        (rev & m5 & ~m6) |
+        (byte_mask(byte, 7) & m6 & ~m5) |
+        (byte_mask(byte, 0) & m6 & m5);
+    ret ^= byte_mask(src3, 4);
+
+    return (ret & ~m7) | (((m5 & BYTES(0x7f)) | (m6 & BYTES(0x80))) & m7);
 }
 
-uint64_t HELPER(pmerge)(uint64_t src1, uint64_t src2, uint64_t src3)
+static uint64_t (*pshufb_accel)(uint64_t, uint64_t, uint64_t) = pshufb_int;
+
+#ifdef CONFIG_AVX2_OPT
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#include <tmmintrin.h>
+
+/* Same as pshufb_int, src2:src1 is a 16 byte table indexed by bits 3:0. */
+static uint64_t pshufb_ssse3(uint64_t src1, uint64_t src2, uint64_t src3)
 {
-    vec64 r, s1, s2, s3;
-    unsigned int i;
+    const __m128i rev_lut = _mm_setr_epi8(0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6,
+        0xe, 0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i table = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i *) &src2),
+        _mm_loadl_epi64((__m128i *) &src1));
+    __m128i desc = _mm_loadl_epi64((__m128i *) &src3);
+    __m128i byte, rev, msb, lsb, b4, b5, b6, b7, ret, cst;
+    uint64_t r;
+
+    byte = _mm_shuffle_epi8(table, _mm_and_si128(desc, nibble));
+    rev = _mm_or_si128(
+        _mm_slli_epi16(_mm_shuffle_epi8(rev_lut,
+            _mm_and_si128(byte, nibble)), 4),
+        _mm_shuffle_epi8(rev_lut,
+            _mm_and_si128(_mm_srli_epi16(byte, 4), nibble)));
+    msb = _mm_cmplt_epi8(byte, zero);
+    lsb = _mm_cmpeq_epi8(_mm_and_si128(byte, _mm_set1_epi8(1)),
+        _mm_set1_epi8(1));
+
+    b4 = _mm_cmpeq_epi8(_mm_and_si128(desc, _mm_set1_epi8(0x10)),
+        _mm_set1_epi8(0x10));
+    b5 = _mm_cmpeq_epi8(_mm_and_si128(desc, _mm_set1_epi8(0x20)),
+        _mm_set1_epi8(0x20));
+    b6 = _mm_cmpeq_epi8(_mm_and_si128(desc, _mm_set1_epi8(0x40)),
+        _mm_set1_epi8(0x40));
+
+    ret = _mm_andnot_si128(_mm_or_si128(b5, b6), byte);
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_andnot_si128(b6, b5), rev));
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_andnot_si128(b5, b6), msb));
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_and_si128(b5, b6), lsb));
+    ret = _mm_xor_si128(ret, b4);
+
+    b7 = _mm_cmplt_epi8(desc, zero);
+    cst = _mm_or_si128(_mm_and_si128(b5, _mm_set1_epi8(0x7f)),
+        _mm_and_si128(b6, _mm_set1_epi8((char) 0x80)));
+    ret = _mm_or_si128(_mm_andnot_si128(b7, ret), _mm_and_si128(b7, cst));
+
+    _mm_storel_epi64((__m128i *) &r, ret);
+    return r;
+}
 
-    s1.ud[0] = src1;
-    s2.ud[0] = src2;
-    s3.ud[0] = src3;
+#pragma GCC pop_options
 
-    for (i = 0; i < 8; i++) {
-        r.ub[i] = s3.sb[i] < 0 ? s2.ub[i] : s1.ub[i];
+#include "qemu/cpuid.h"
+
+static void __attribute__((constructor)) init_pshufb_accel(void)
+{
+    unsigned a, b, c, d;
+
+    if (__get_cpuid_max(0, NULL) >= 1) {
+        __cpuid(1, a, b, c, d);
+        if (c & bit_SSSE3) {
+            pshufb_accel = pshufb_ssse3;
+        }
     }
+}
+#endif /* CONFIG_AVX2_OPT */
+
+uint64_t HELPER(pshufb)(uint64_t src1, uint64_t src2, uint64_t src3)
+{
+    return pshufb_accel(src1, src2, src3);
+}
+
+uint64_t HELPER(pmerge)(uint64_t src1, uint64_t src2, uint64_t src3)
+{
+    uint64_t mask = byte_mask(src3, 7);
 
-    return r.ud[0];
+    return (src1 & ~mask) | (src2 & mask);
 }
 
 uint64_t HELPER(pshufh)(uint64_t src1, uint32_t imm8)
@@ -336,72 +309,165 @@ uint64_t HELPER(phminposuh)(uint64_t src1, uint64_t src2)
     return dst.ud[0];
 }
 
-static uint64_t get_value_from_truth_table(bool x, bool y, bool z, uint32_t truth_table)
+/*
+ * Packed float32 ops run both lanes with one host vector instruction when
+ * the result is known to match softfloat. That is the case for zero or
+ * normal operands if the rounding mode is nearest-even and neither inputs
+ * nor outputs are flushed to zero. Flags are the other half: with every
+ * exception masked and float_flag_inexact already sticky (see
+ * e2k_update_fp_flags) the only flag a host op can raise is already set.
+ * A result that overflowed or may have underflowed needs its flags raised
+ * precisely, so the whole op is redone in softfloat.
+ */
+static inline bool pf_can_use_host(CPUE2KState *env)
 {
-    int pos = x << 2 | y << 1 | z;
-    return (truth_table >> pos) & 1ULL;
+    float_status *s = &env->fp_status;
+
+    return (env->fpcr.em & FPCR_EM) == FPCR_EM &&
+        get_float_rounding_mode(s) == float_round_nearest_even &&
+        (get_float_exception_flags(s) & float_flag_inexact) &&
+        !get_flush_to_zero(s) && !get_flush_inputs_to_zero(s);
 }
 
-uint64_t HELPER(plog)(uint32_t opc, uint64_t src1, uint64_t src2, uint64_t src3)
+static inline bool pf_is_zon(vec64 a)
 {
-    int i;
-    uint64_t ret = 0;
+    return float32_is_zero_or_normal(make_float32(a.uw[0])) &&
+        float32_is_zero_or_normal(make_float32(a.uw[1]));
+}
+
+static inline bool pf_is_zon2(vec64 a, vec64 b)
+{
+    return pf_is_zon(a) && pf_is_zon(b);
+}
 
-    for (i = 0; i < 64; i++) {
-        uint32_t x = extract64(src1, i, 1);
-        uint32_t y = extract64(src2, i, 1);
-        uint32_t z = extract64(src3, i, 1);
+/* The sum of two normals is exact if it is tiny, so only overflow is left. */
+static inline bool pf_addsub_post(vec64 s1, vec64 s2, vec64 r)
+{
+    return !float32_is_infinity(make_float32(r.uw[0])) &&
+        !float32_is_infinity(make_float32(r.uw[1]));
+}
 
-        uint64_t bit = get_value_from_truth_table(x, y, z, opc);
+static inline bool pf_mul_post_lane(uint32_t a, uint32_t b, uint32_t r)
+{
+    uint32_t exp = extract32(r, 23, 8);
 
-        ret |= bit << i;
+    if (float32_is_zero(make_float32(a)) || float32_is_zero(make_float32(b))) {
+        return true;
     }
+    return exp > 1 && exp < 0xff;
+}
 
-    return ret;
+static inline bool pf_mul_post(vec64 s1, vec64 s2, vec64 r)
+{
+    return pf_mul_post_lane(s1.uw[0], s2.uw[0], r.uw[0]) &&
+        pf_mul_post_lane(s1.uw[1], s2.uw[1], r.uw[1]);
 }
 
-#define GEN_ENV_HELPER_PACKED_N(name, n, code) \
+static inline bool pf_no_host(CPUE2KState *env, vec64 *ret, vec64 s1,
+    vec64 s2)
+{
+    return false;
+}
+
+#define GEN_PF_HOST_OP(name, expr, post) \
+    static inline bool name(CPUE2KState *env, vec64 *ret, vec64 s1, \
+        vec64 s2) \
+    { \
+        if (!pf_can_use_host(env) || !pf_is_zon2(s1, s2)) { \
+            return false; \
+        } \
+        ret->fs = expr; \
+        return post(s1, s2, *ret); \
+    }
+
+#define pf_lo(s1, s2) ((vec64_fs) { s1.fs[0], s2.fs[0] })
+#define pf_hi(s1, s2) ((vec64_fs) { s1.fs[1], s2.fs[1] })
+#define pf_neg_lo(s2) ((vec64) { .ud[0] = s2.ud[0] ^ 0x80000000 }).fs
+
+GEN_PF_HOST_OP(pf_host_adds, s1.fs + s2.fs, pf_addsub_post)
+GEN_PF_HOST_OP(pf_host_subs, s1.fs - s2.fs, pf_addsub_post)
+GEN_PF_HOST_OP(pf_host_muls, s1.fs * s2.fs, pf_mul_post)
+GEN_PF_HOST_OP(pf_host_hadds, pf_lo(s1, s2) + pf_hi(s1, s2), pf_addsub_post)
+GEN_PF_HOST_OP(pf_host_hsubs, pf_lo(s1, s2) - pf_hi(s1, s2), pf_addsub_post)
+/* a - b is a + -b, lane 0 subtracts and lane 1 adds */
+GEN_PF_HOST_OP(pf_host_addsubs, s1.fs + pf_neg_lo(s2), pf_addsub_post)
+
+/* Comparisons of non-NaN operands are exact and raise no flags. */
+#define GEN_PF_HOST_CMP(name, expr) \
+    static inline bool name(CPUE2KState *env, vec64 *ret, vec64 s1, \
+        vec64 s2) \
+    { \
+        if (get_flush_inputs_to_zero(&env->fp_status) || \
+            float32_is_any_nan(make_float32(s1.uw[0])) || \
+            float32_is_any_nan(make_float32(s1.uw[1])) || \
+            float32_is_any_nan(make_float32(s2.uw[0])) || \
+            float32_is_any_nan(make_float32(s2.uw[1]))) { \
+            return false; \
+        } \
+        ret->mask = expr; \
+        return true; \
+    }
+
+GEN_PF_HOST_CMP(pf_host_cmpeqs,  s1.fs == s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmplts,  s1.fs < s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmples,  s1.fs <= s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmpuods, ((vec64_mask) { 0, 0 }))
+GEN_PF_HOST_CMP(pf_host_cmpneqs, s1.fs != s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmpnlts, s1.fs >= s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmpnles, s1.fs > s2.fs)
+GEN_PF_HOST_CMP(pf_host_cmpods,  ((vec64_mask) { -1, -1 }))
+
+#define GEN_ENV_HELPER_PACKED_N_HOST(name, n, host, code) \
     uint64_t HELPER(name)(CPUE2KState *env, uint64_t src1, uint64_t src2) \
     { \
         size_t i = 0; \
         vec64 s1 = { .ud[0] = src1 }, s2 = { .ud[0] = src2 }; \
         vec64 dst = { .ud[0] = 0 }; \
+        if (host(env, &dst, s1, s2)) { \
+            return dst.ud[0]; \
+        } \
         for (; i < n; i++) { \
             code \
         } \
         return dst.ud[0]; \
     }
+#define GEN_ENV_HELPER_PACKED_N(name, n, code) \
+    GEN_ENV_HELPER_PACKED_N_HOST(name, n, pf_no_host, code)
 #define GEN_ENV_HELPER_PACKED(name, type, code) \
     GEN_ENV_HELPER_PACKED_N(name, vec64_len(type), code)
+#define GEN_ENV_HELPER_PACKED_HOST(name, type, host, code) \
+    GEN_ENV_HELPER_PACKED_N_HOST(name, vec64_len(type), host, code)
 #define GEN_ENV_HELPER_PACKED_OP(name, type, op) \
-    GEN_ENV_HELPER_PACKED_N(name, vec64_len(type), { \
+    GEN_ENV_HELPER_PACKED_OP_HOST(name, type, op, pf_no_host)
+#define GEN_ENV_HELPER_PACKED_OP_HOST(name, type, op, host) \
+    GEN_ENV_HELPER_PACKED_N_HOST(name, vec64_len(type), host, { \
         dst.type[i] = op(env, s1.type[i], s2.type[i]); \
     })
-#define GEN_ENV_HELPER_PACKED_HORIZONTAL_OP(name, type, op, map) \
-    GEN_ENV_HELPER_PACKED_N(name, vec64_len(type) / 2, { \
+#define GEN_ENV_HELPER_PACKED_HORIZONTAL_OP_HOST(name, type, op, map, host) \
+    GEN_ENV_HELPER_PACKED_N_HOST(name, vec64_len(type) / 2, host, { \
         int j = i * 2; \
         dst.type[i                      ] = map(op(env, s1.type[j], s1.type[j + 1])); \
         dst.type[i + vec64_len(type) / 2] = map(op(env, s2.type[j], s2.type[j + 1])); \
     })
 
-GEN_ENV_HELPER_PACKED_OP(pfadds, uw, helper_fadds)
-GEN_ENV_HELPER_PACKED_OP(pfsubs, uw, helper_fsubs)
-GEN_ENV_HELPER_PACKED_OP(pfmuls, uw, helper_fmuls)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfadds, uw, helper_fadds, pf_host_adds)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfsubs, uw, helper_fsubs, pf_host_subs)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfmuls, uw, helper_fmuls, pf_host_muls)
 GEN_ENV_HELPER_PACKED_OP(pfmaxs, uw, helper_fmaxs)
 GEN_ENV_HELPER_PACKED_OP(pfmins, uw, helper_fmins)
-GEN_ENV_HELPER_PACKED_HORIZONTAL_OP(pfhadds, uw, helper_fadds, ident)
-GEN_ENV_HELPER_PACKED_HORIZONTAL_OP(pfhsubs, uw, helper_fsubs, ident)
-
-GEN_ENV_HELPER_PACKED_OP(pfcmpeqs,  uw, helper_fcmpeqs)
-GEN_ENV_HELPER_PACKED_OP(pfcmplts,  uw, helper_fcmplts)
-GEN_ENV_HELPER_PACKED_OP(pfcmples,  uw, helper_fcmples)
-GEN_ENV_HELPER_PACKED_OP(pfcmpuods, uw, helper_fcmpuods)
-GEN_ENV_HELPER_PACKED_OP(pfcmpneqs, uw, helper_fcmpneqs)
-GEN_ENV_HELPER_PACKED_OP(pfcmpnlts, uw, helper_fcmpnlts)
-GEN_ENV_HELPER_PACKED_OP(pfcmpnles, uw, helper_fcmpnles)
-GEN_ENV_HELPER_PACKED_OP(pfcmpods,  uw, helper_fcmpods)
-
-GEN_ENV_HELPER_PACKED(pfaddsubs, uw, { \
+GEN_ENV_HELPER_PACKED_HORIZONTAL_OP_HOST(pfhadds, uw, helper_fadds, ident, pf_host_hadds)
+GEN_ENV_HELPER_PACKED_HORIZONTAL_OP_HOST(pfhsubs, uw, helper_fsubs, ident, pf_host_hsubs)
+
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpeqs,  uw, helper_fcmpeqs,  pf_host_cmpeqs)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmplts,  uw, helper_fcmplts,  pf_host_cmplts)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmples,  uw, helper_fcmples,  pf_host_cmples)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpuods, uw, helper_fcmpuods, pf_host_cmpuods)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpneqs, uw, helper_fcmpneqs, pf_host_cmpneqs)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpnlts, uw, helper_fcmpnlts, pf_host_cmpnlts)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpnles, uw, helper_fcmpnles, pf_host_cmpnles)
+GEN_ENV_HELPER_PACKED_OP_HOST(pfcmpods,  uw, helper_fcmpods,  pf_host_cmpods)
+
+GEN_ENV_HELPER_PACKED_HOST(pfaddsubs, uw, pf_host_addsubs, { \
     if (i & 1) { \
         dst.uw[i] = helper_fadds(env, s1.uw[i], s2.uw[i]); \
     } else { \
@@ -409,21 +475,44 @@ GEN_ENV_HELPER_PACKED(pfaddsubs, uw, { \
     } \
 })
 
-#define GEN_ENV_HELPER_PACKED_UNARY_N(name, n, code) \
+static inline bool pf_no_host_unary(CPUE2KState *env, vec64 *ret, vec64 s2)
+{
+    return false;
+}
+
+/* Integers of at most 24 bits convert exactly, in any rounding mode. */
+static inline bool pf_host_istofs(CPUE2KState *env, vec64 *ret, vec64 s2)
+{
+    if (s2.sw[0] < -(1 << 24) || s2.sw[0] > (1 << 24) ||
+        s2.sw[1] < -(1 << 24) || s2.sw[1] > (1 << 24)) {
+        return false;
+    }
+    ret->fs = (vec64_fs) { s2.sw[0], s2.sw[1] };
+    return true;
+}
+
+#define GEN_ENV_HELPER_PACKED_UNARY_N_HOST(name, n, host, code) \
     uint64_t HELPER(name)(CPUE2KState *env, uint64_t src2) \
     { \
         size_t i = 0; \
         vec64 s2 = { .ud[0] = src2 }; \
         vec64 dst = { .ud[0] = 0 }; \
+        if (host(env, &dst, s2)) { \
+            return dst.ud[0]; \
+        } \
         for (; i < n; i++) { \
             code \
         } \
         return dst.ud[0]; \
     }
+#define GEN_ENV_HELPER_PACKED_UNARY_N(name, n, code) \
+    GEN_ENV_HELPER_PACKED_UNARY_N_HOST(name, n, pf_no_host_unary, code)
 #define GEN_ENV_HELPER_PACKED_UNARY(name, type, code) \
     GEN_ENV_HELPER_PACKED_UNARY_N(name, vec64_len(type), code)
 #define GEN_ENV_HELPER_PACKED_UNARY_OP(name, type, op) \
-    GEN_ENV_HELPER_PACKED_UNARY_N(name, vec64_len(type), { \
+    GEN_ENV_HELPER_PACKED_UNARY_OP_HOST(name, type, op, pf_no_host_unary)
+#define GEN_ENV_HELPER_PACKED_UNARY_OP_HOST(name, type, op, host) \
+    GEN_ENV_HELPER_PACKED_UNARY_N_HOST(name, vec64_len(type), host, { \
         dst.type[i] = op(env, s2.type[i]); \
     })
 
@@ -433,6 +522,6 @@ GEN_ENV_HELPER_PACKED(pfaddsubs, uw, { \
     })
 
 GEN_ENV_HELPER_PACKED_OP_CVT(pfstoifs, uw, helper_fstoifs)
-GEN_ENV_HELPER_PACKED_UNARY_OP(pistofs, uw, helper_istofs)
+GEN_ENV_HELPER_PACKED_UNARY_OP_HOST(pistofs, uw, helper_istofs, pf_host_istofs)
 GEN_ENV_HELPER_PACKED_UNARY_OP(pfstois, uw, helper_fstois)
 GEN_ENV_HELPER_PACKED_UNARY_OP(pfstoistr, uw, helper_fstoistr)
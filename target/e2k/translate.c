@@ -38,10 +38,41 @@ static inline bool use_goto_tb(DisasContext *s, target_ulong pc,
 #endif
 }
 
+void e2k_gen_lsr_changed(DisasContext *ctx)
+{
+    ctx->loop_kernel = false;
+    ctx->lsr_dirty = true;
+}
+
+/*
+ * A direct jump is only linked while the loop phase is the same as at the
+ * TB start, so it is valid as long as the phase has not changed.
+ */
+static void gen_loop_phase_check(DisasContext *ctx, target_ulong npc)
+{
+    TCGLabel *l0 = gen_new_label();
+    TCGv_i32 t0 = tcg_temp_new_i32();
+    TCGv_i32 t1 = tcg_temp_new_i32();
+
+    tcg_gen_setcondi_i32(TCG_COND_EQ, t0, e2k_cs.lsr_pcnt, 0);
+    tcg_gen_setcondi_i32(TCG_COND_GEU, t1, e2k_cs.lsr_lcnt, 2);
+    tcg_gen_and_i32(t0, t0, t1);
+    tcg_gen_brcondi_i32(TCG_COND_EQ, t0, ctx->loop_kernel_tb, l0);
+    tcg_gen_movi_tl(e2k_cs.pc, npc);
+    tcg_gen_lookup_and_goto_ptr();
+    gen_set_label(l0);
+
+    tcg_temp_free_i32(t1);
+    tcg_temp_free_i32(t0);
+}
+
 static inline void gen_goto_tb(DisasContext *ctx, int tb_num,
     target_ulong pc, target_ulong npc)
 {
     if (use_goto_tb(ctx, pc, npc))  {
+        if (ctx->lsr_dirty) {
+            gen_loop_phase_check(ctx, npc);
+        }
         /* jump to same page: we can use a direct jump */
         tcg_gen_goto_tb(tb_num);
         tcg_gen_movi_tl(e2k_cs.pc, npc);
@@ -84,10 +115,44 @@ static inline void illop(DisasContext *ctx)
 //// Decode
 ////////////////////////////////////////////////////////////////////
 
+#define E2K_BUNDLE_MAX_SIZE 64
+
+static inline unsigned int bundle_len(uint32_t hs)
+{
+    return 8 + extract32(hs, 4, 3) * 8;
+}
+
+/*
+ * Copies the whole bundle at PC into BUF. A bundle which does not cross a
+ * page boundary is read with a single host access.
+ */
+static void fetch_bundle(CPUE2KState *env, target_ulong pc, uint8_t *buf)
+{
+    target_ulong page_left = -(pc | TARGET_PAGE_MASK);
+    unsigned int i, len;
+
+    if (likely(page_left >= E2K_BUNDLE_MAX_SIZE)) {
+        /* the tail of the buffer may hold the next bundles, which is fine */
+        set_helper_retaddr(1);
+        memcpy(buf, g2h(pc), E2K_BUNDLE_MAX_SIZE);
+        clear_helper_retaddr();
+        len = bundle_len(ldl_le_p(buf));
+    } else {
+        stl_le_p(buf, cpu_ldl_code(env, pc));
+        len = bundle_len(ldl_le_p(buf));
+        for (i = 4; i < len; i += 4) {
+            stl_le_p(buf + i, cpu_ldl_code(env, pc + i));
+        }
+    }
+
+    plugin_insn_append(buf, len);
+}
+
 /* returns zero if bundle is invalid */
 static size_t unpack_bundle(CPUE2KState *env,
     target_ulong pc, UnpackedBundle *bundle)
 {
+    uint8_t buf[E2K_BUNDLE_MAX_SIZE];
     unsigned int gap;
     unsigned int pos = 0;
     unsigned int mdl;
@@ -95,31 +160,38 @@ static size_t unpack_bundle(CPUE2KState *env,
     unsigned int i;
     uint32_t hs;
 
-    memset(bundle, 0, sizeof(UnpackedBundle));
+    fetch_bundle(env, pc, buf);
 
-    bundle->hs = hs = translator_ldl(env, pc + pos);
+    /* Syllables are only read if present, except for these ones. */
+    bundle->ss = 0;
+    memset(bundle->ales, 0, sizeof(bundle->ales));
+    memset(bundle->ales_present, 0, sizeof(bundle->ales_present));
+    memset(bundle->aas, 0, sizeof(bundle->aas));
+    memset(bundle->aas_present, 0, sizeof(bundle->aas_present));
+
+    bundle->hs = hs = ldl_le_p(buf + pos);
     pos += 4;
 
     /* Check for SS.  */
-    if (GET_BIT(hs, 12)) {
-        bundle->ss_present = true;
-        bundle->ss = translator_ldl(env, pc + pos);
+    bundle->ss_present = GET_BIT(hs, 12);
+    if (bundle->ss_present) {
+        bundle->ss = ldl_le_p(buf + pos);
         pos += 4;
     }
 
     /* Check for available ALS syllables.  */
     for (i = 0; i < 6; i++) {
-        if (GET_BIT(hs, 26 + i)) {
-            bundle->als_present[i] = true;
-            bundle->als[i] = translator_ldl(env, pc + pos);
+        bundle->als_present[i] = GET_BIT(hs, 26 + i);
+        if (bundle->als_present[i]) {
+            bundle->als[i] = ldl_le_p(buf + pos);
             pos += 4;
         }
     }
 
     /* Check for CS0.  */
-    if (GET_BIT(hs, 14)) {
-        bundle->cs0_present = true;
-        bundle->cs0 = translator_ldl(env, pc + pos);
+    bundle->cs0_present = GET_BIT(hs, 14);
+    if (bundle->cs0_present) {
+        bundle->cs0 = ldl_le_p(buf + pos);
         pos += 4;
     }
 
@@ -148,8 +220,8 @@ static size_t unpack_bundle(CPUE2KState *env,
         /* Fill in ALES5 and ALES2 syllables even if none of them is specified in
            HS as present. This will let me output this syllable into disassembly
            whichever case takes place. */
-        bundle->ales[5] = translator_lduw(env, pc + pos);
-        bundle->ales[2] = translator_lduw(env, pc + pos + 2);
+        bundle->ales[5] = lduw_le_p(buf + pos);
+        bundle->ales[2] = lduw_le_p(buf + pos + 2);
 
         /* Adjust `ALES_PRESENT[{5,2}]' as proposed above now that we know that
            they are allocated.  */
@@ -160,12 +232,16 @@ static size_t unpack_bundle(CPUE2KState *env,
     }
 
     /* Check for CS1.  */
-    if (GET_BIT(hs, 15)) {
-        bundle->cs1_present = 1;
-        bundle->cs1 = translator_ldl(env, pc + pos);
+    bundle->cs1_present = GET_BIT(hs, 15);
+    if (bundle->cs1_present) {
+        bundle->cs1 = ldl_le_p(buf + pos);
         pos += 4;
     }
 
+    memset(bundle->lts_present, 0, sizeof(bundle->lts_present));
+    memset(bundle->pls_present, 0, sizeof(bundle->pls_present));
+    memset(bundle->cds_present, 0, sizeof(bundle->cds_present));
+
     /* A primitive control just for a moment.  */
     if (mdl != pos) {
         /* This is either an APB instruction or an invalid one. Let's stupidly
@@ -185,7 +261,7 @@ static size_t unpack_bundle(CPUE2KState *env,
 
             /* Recall the idiotic order of half-syllables in the packed wide
                instruction.  */
-            bundle->ales[i] = translator_lduw(env, pc + pos + offset);
+            bundle->ales[i] = lduw_le_p(buf + pos + offset);
             hsyll_cntr++;
         }
     }
@@ -206,7 +282,7 @@ static size_t unpack_bundle(CPUE2KState *env,
                 /* Recall the idiotic order of half-syllables in the packed wide
                    instruction. Note that the first AAS half-syllable may share a
                    syllable with the last ALES.  */
-                bundle->aas[i] = translator_lduw(env, pc + pos + offset);
+                bundle->aas[i] = lduw_le_p(buf + pos + offset);
                 hsyll_cntr++;
             }
         }
@@ -229,14 +305,14 @@ static size_t unpack_bundle(CPUE2KState *env,
     /* Check for CDSj syllables.  */
     for (i = 0; i < extract32(hs, 16, 2); i++) {
         bundle->cds_present[i] = true;
-        bundle->cds[i] = translator_ldl(env, pc + pos);
+        bundle->cds[i] = ldl_le_p(buf + pos);
         pos -= 4;
     }
 
     /* Check for PLSj syllables.  */
     for (i = 0; i < extract32(hs, 18, 2); i++) {
         bundle->pls_present[i] = true;
-        bundle->pls[i] = translator_ldl(env, pc + pos);
+        bundle->pls[i] = ldl_le_p(buf + pos);
         pos -= 4;
     }
 
@@ -256,11 +332,11 @@ static size_t unpack_bundle(CPUE2KState *env,
     /* Extract available LTSj syllables.  */
     for (i = 0; i < 4 && pos >= gap; i++) {
         bundle->lts_present[i] = true;
-        bundle->lts[i] = translator_ldl(env, pc + pos);
+        bundle->lts[i] = ldl_le_p(buf + pos);
         pos -= 4;
     }
 
-    return 8 + extract32(hs, 4, 3) * 8;
+    return bundle_len(hs);
 }
 
 static inline uint8_t ss_extract_ipd(const UnpackedBundle *raw)
@@ -495,6 +571,7 @@ static inline void decode_ct_cond(DisasContext *ctx, const UnpackedBundle *raw)
             ctx->ct.type = CT_JUMP;
         }
         ctx->ct.u.ctpr = e2k_cs.ctprs[ctpr - 1];
+        ctx->ct.ctpr_index = ctpr - 1;
     }
     ctx->ct.psrc = extract32(raw->ss, 0, 5);
     ctx->ct.cond_type = extract32(raw->ss, 5, 4);
@@ -504,10 +581,11 @@ static inline void decode_ct_cond(DisasContext *ctx, const UnpackedBundle *raw)
 //// Generate
 ////////////////////////////////////////////////////////////////////
 
-static inline void gen_set_ctpr(int index, uint64_t ctpr)
+static inline void gen_set_ctpr(DisasContext *ctx, int index, uint64_t ctpr)
 {
     assert(0 < index && index < 4);
     tcg_gen_movi_i64(e2k_cs.ctprs[index - 1], ctpr);
+    ctx->ctprs[index - 1].raw = ctpr;
 }
 
 static inline void gen_ctpr_tag(TCGv_i64 ret, TCGv_i64 ctpr)
@@ -562,10 +640,12 @@ static inline void gen_setbn(DisasContext *ctx)
     Cs1Setr *setr = &cs1->setr;
 
     if (cs1->type == CS1_SETR && (setr->type & SETR_BN)) {
+        ctx->boff = setr->rbs * 2;
         ctx->bsize = (setr->rsz + 1) * 2;
         tcg_gen_movi_i32(e2k_cs.boff, setr->rbs * 2);
         tcg_gen_movi_i32(e2k_cs.bsize, (setr->rsz + 1) * 2);
-        tcg_gen_movi_i32(e2k_cs.bcur, setr->rcur * 2);
+        /* keep bcur below bsize, rotation relies on it */
+        tcg_gen_movi_i32(e2k_cs.bcur, (setr->rcur * 2) % ctx->bsize);
     }
 }
 
@@ -575,6 +655,7 @@ static inline void gen_setbp(DisasContext *ctx)
     Cs1Setr *setr = &cs1->setr;
 
     if (cs1->type == CS1_SETR && (setr->type & SETR_BP)) {
+        ctx->psize = setr->psz;
         tcg_gen_movi_i32(e2k_cs.psize, setr->psz);
         tcg_gen_movi_i32(e2k_cs.pcur, 0);
     }
@@ -605,7 +686,10 @@ static inline void gen_cs1(DisasContext *ctx)
         // TODO: wait
         break;
     case CS1_FLUSH:
-        // TODO: flush
+        if (cs1->flush.flushr) {
+            gen_helper_flushr(cpu_env);
+        }
+        // TODO: flushc
         break;
     default:
         e2k_todo_illop(ctx, "unimplemented %d", cs1->type);
@@ -629,7 +713,7 @@ static inline void gen_cs0(DisasContext *ctx)
         break;
     case CS0_DISP: {
         uint64_t ctpr = ctpr_new_disp(ctx, &cs0->disp);
-        gen_set_ctpr(cs0->disp.ctpr, ctpr);
+        gen_set_ctpr(ctx, cs0->disp.ctpr, ctpr);
         break;
     }
     case CS0_SDISP: {
@@ -637,12 +721,13 @@ static inline void gen_cs0(DisasContext *ctx)
         target_ulong target = 0xe2UL << 40;
         target = deposit64(target, 11, 17, cs0->sdisp.disp);
         uint64_t ctpr = ctpr_new(CTPR_TAG_SDISP, 0, cs0->sdisp.ipd, target);
-        gen_set_ctpr(cs0->sdisp.ctpr, ctpr);
+        gen_set_ctpr(ctx, cs0->sdisp.ctpr, ctpr);
         break;
     }
     case CS0_RETURN: {
         TCGv_i32 t0 = tcg_const_i32(cs0->ret.ipd);
         gen_helper_prep_return(e2k_cs.ctprs[2], cpu_env, t0);
+        ctx->ctprs[2].raw = 0;
         tcg_temp_free_i32(t0);
         break;
     }
@@ -674,13 +759,13 @@ static inline void gen_ct_cond(DisasContext *ctx)
     case 0x6:
     case 0xf:
         /* %predN */
-        e2k_gen_preg_i32(pcond, ct->psrc);
+        e2k_gen_preg_i32(ctx, pcond, ct->psrc);
         break;
     case 0x3:
     case 0x7:
     case 0xe: {
         TCGv_i32 t0 = tcg_temp_new_i32();
-        e2k_gen_preg_i32(t0, ct->psrc);
+        e2k_gen_preg_i32(ctx, t0, ct->psrc);
         tcg_gen_setcondi_i32(TCG_COND_EQ, pcond, t0, 0);
         tcg_temp_free_i32(t0);
         break;
@@ -694,13 +779,13 @@ static inline void gen_ct_cond(DisasContext *ctx)
     case 0x6:
     case 0xe:
         /* #LOOP_END */
-        e2k_gen_is_loop_end_i32(lcond);
+        e2k_gen_is_loop_end_i32(ctx, lcond);
         break;
     case 0x5:
     case 0x7:
     case 0xf: { /* #NOT_LOOP_END */
         TCGv_i32 t0 = tcg_temp_new_i32();
-        e2k_gen_is_loop_end_i32(t0);
+        e2k_gen_is_loop_end_i32(ctx, t0);
         tcg_gen_setcondi_i32(TCG_COND_EQ, lcond, t0, 0);
         tcg_temp_free_i32(t0);
         break;
@@ -725,7 +810,12 @@ static inline void gen_ct_cond(DisasContext *ctx)
         TCGv_i32 t0 = tcg_temp_new_i32();
 
         tcg_gen_or_i32(t0, pcond, lcond);
-        tcg_gen_movcond_i32(TCG_COND_EQ, e2k_cs.ct_cond, e2k_cs.lsr_pcnt, z, t0, lcond);
+        if (ctx->loop_kernel) {
+            tcg_gen_mov_i32(e2k_cs.ct_cond, t0);
+        } else {
+            tcg_gen_movcond_i32(TCG_COND_EQ, e2k_cs.ct_cond, e2k_cs.lsr_pcnt,
+                z, t0, lcond);
+        }
         tcg_temp_free_i32(t0);
         tcg_temp_free_i32(z);
         break;
@@ -737,7 +827,12 @@ static inline void gen_ct_cond(DisasContext *ctx)
         TCGv_i32 t0 = tcg_temp_new_i32();
 
         tcg_gen_and_i32(t0, pcond, lcond);
-        tcg_gen_movcond_i32(TCG_COND_EQ, e2k_cs.ct_cond, e2k_cs.lsr_pcnt, z, t0, lcond);
+        if (ctx->loop_kernel) {
+            tcg_gen_mov_i32(e2k_cs.ct_cond, t0);
+        } else {
+            tcg_gen_movcond_i32(TCG_COND_EQ, e2k_cs.ct_cond, e2k_cs.lsr_pcnt,
+                z, t0, lcond);
+        }
         tcg_temp_free_i32(t0);
         tcg_temp_free_i32(z);
         break;
@@ -822,31 +917,28 @@ static void gen_movcond_flag_i32(TCGv_i32 ret, int flag, TCGv_i32 cond,
     tcg_temp_free_i32(one);
 }
 
-static inline void gen_dec_wrap(TCGv_i32 ret, TCGv_i32 cur, int n,
-    TCGv_i32 size)
+static inline void gen_cur_dec(DisasContext *ctx, TCGv_i32 ret, int cond,
+    TCGv_i32 cur, int n, int size)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
+    TCGv_i32 z, t0, t1;
 
-    tcg_gen_addi_i32(t0, size, n);
-    tcg_gen_sub_i32(t0, t0, cur);
-    tcg_gen_remu_i32(t0, t0, size);
-    tcg_gen_sub_i32(ret, size, t0);
-
-    tcg_temp_free_i32(t0);
-}
+    if (size <= n) {
+        /* cur is always zero, nothing to rotate */
+        return;
+    }
 
-static inline void gen_cur_dec(DisasContext *ctx, TCGv_i32 ret, int cond,
-    TCGv_i32 cur, int n, TCGv_i32 size)
-{
-    TCGLabel *l0 = gen_new_label();
-    TCGv_i32 t0 = tcg_temp_new_i32();
+    z = tcg_const_i32(0);
+    t0 = tcg_temp_new_i32();
+    t1 = tcg_const_i32(size - n);
 
-    tcg_gen_brcondi_i32(TCG_COND_EQ, size, 0, l0);
-    gen_dec_wrap(t0, cur, n, size);
+    /* cur is kept below size, so it wraps only when it is zero */
+    tcg_gen_subi_i32(t0, cur, n);
+    tcg_gen_movcond_i32(TCG_COND_EQ, t0, cur, z, t1, t0);
     gen_movcond_flag_i32(ret, cond, e2k_cs.ct_cond, t0, cur);
-    gen_set_label(l0);
 
+    tcg_temp_free_i32(t1);
     tcg_temp_free_i32(t0);
+    tcg_temp_free_i32(z);
 }
 
 static void gen_dec_sat_i32(TCGv_i32 ret, TCGv_i32 arg0)
@@ -859,13 +951,22 @@ static void gen_dec_sat_i32(TCGv_i32 ret, TCGv_i32 arg0)
     tcg_temp_free_i32(t0);
 }
 
-static void gen_advance_loop_counters(void)
+static void gen_advance_loop_counters(DisasContext *ctx)
 {
-    TCGv_i32 z = tcg_const_i32(0);
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-    TCGv_i32 t2 = tcg_temp_new_i32();
-    TCGv_i32 t3 = tcg_temp_new_i32();
+    TCGv_i32 z, t0, t1, t2, t3;
+
+    if (ctx->loop_kernel) {
+        /* pcnt is zero and lcnt cannot reach zero, ecnt is unchanged */
+        tcg_gen_subi_i32(e2k_cs.lsr_lcnt, e2k_cs.lsr_lcnt, 1);
+        tcg_gen_movi_i32(e2k_cs.lsr_over, 0);
+        return;
+    }
+
+    z = tcg_const_i32(0);
+    t0 = tcg_temp_new_i32();
+    t1 = tcg_temp_new_i32();
+    t2 = tcg_temp_new_i32();
+    t3 = tcg_temp_new_i32();
 
     gen_dec_sat_i32(e2k_cs.lsr_pcnt, e2k_cs.lsr_pcnt);
     gen_dec_sat_i32(e2k_cs.lsr_lcnt, e2k_cs.lsr_lcnt);
@@ -897,19 +998,17 @@ static inline void gen_stubs(DisasContext *ctx)
         TCGCond cond = cond_from_advance(alc);
 
         tcg_gen_brcondi_i32(tcg_invert_cond(cond), e2k_cs.ct_cond, 1, l0);
-        gen_advance_loop_counters();
+        gen_advance_loop_counters(ctx);
         gen_set_label(l0);
+        e2k_gen_lsr_changed(ctx);
     }
 
     if (abp) {
-        TCGv_i32 t0 = tcg_temp_local_new_i32();
-        tcg_gen_addi_i32(t0, e2k_cs.psize, 1);
-        gen_cur_dec(ctx, e2k_cs.pcur, abp, e2k_cs.pcur, 1, t0);
-        tcg_temp_free_i32(t0);
+        gen_cur_dec(ctx, e2k_cs.pcur, abp, e2k_cs.pcur, 1, ctx->psize + 1);
     }
 
     if (abn) {
-        gen_cur_dec(ctx, e2k_cs.bcur, abn, e2k_cs.bcur, 2, e2k_cs.bsize);
+        gen_cur_dec(ctx, e2k_cs.bcur, abn, e2k_cs.bcur, 2, ctx->bsize);
     }
 
     if (abg != 0) {
@@ -952,6 +1051,35 @@ static inline void gen_maperr_condi_i32(TCGCond cond, TCGv_i32 arg1, int arg2)
     gen_set_label(l0);
 }
 
+/*
+ * Restarts the bundle in a TB with full tag tracking if any source register
+ * of the bundle has a non-numeric tag. Runs before anything of the bundle
+ * is executed, so the bundle is executed only once.
+ */
+static void gen_tags_check(DisasContext *ctx)
+{
+    TCGLabel *l0;
+    TCGv_i32 t0;
+
+    memset(ctx->src_checked, 0, sizeof(ctx->src_checked));
+    if (!ctx->fast_tags) {
+        return;
+    }
+
+    l0 = gen_new_label();
+    t0 = tcg_temp_new_i32();
+
+    e2k_alc_gen_src_tags(ctx, t0);
+    tcg_gen_brcondi_i32(TCG_COND_EQ, t0, 0, l0);
+    e2k_gen_save_cpu_state(ctx);
+    tcg_gen_movi_i32(t0, 1);
+    tcg_gen_st_i32(t0, cpu_env, offsetof(CPUE2KState, tags_full));
+    tcg_gen_exit_tb(NULL, TB_EXIT_IDX0);
+    gen_set_label(l0);
+
+    tcg_temp_free_i32(t0);
+}
+
 static inline void do_checks(DisasContext *ctx)
 {
     const Bundle *b = &ctx->bundle2;
@@ -1063,9 +1191,18 @@ static inline void do_branch(DisasContext *ctx, target_ulong pc_next)
         gen_goto_tb(ctx, TB_EXIT_IDX1, ctx->pc, ctx->ct.u.target);
         break;
     case CT_JUMP: {
-        TCGLabel *l0 = gen_new_label();
-        TCGLabel *l1 = gen_new_label();
-        TCGv_i64 t0 = tcg_temp_local_new_i64();
+        E2KCtpr ctpr = ctx->ctprs[ctx->ct.ctpr_index];
+        TCGLabel *l0, *l1;
+        TCGv_i64 t0;
+
+        if (ctpr.tag == CTPR_TAG_DISP) {
+            gen_goto_tb(ctx, TB_EXIT_IDX1, ctx->pc, ctpr.base);
+            break;
+        }
+
+        l0 = gen_new_label();
+        l1 = gen_new_label();
+        t0 = tcg_temp_local_new_i64();
 
         gen_ctpr_tag(t0, ctx->ct.u.ctpr);
         tcg_gen_brcondi_i64(TCG_COND_EQ, t0, CTPR_TAG_DISP, l0);
@@ -1083,11 +1220,20 @@ static inline void do_branch(DisasContext *ctx, target_ulong pc_next)
         break;
     }
     case CT_CALL: {
+        E2KCtpr ctpr = ctx->ctprs[ctx->ct.ctpr_index];
         TCGv_i32 wbs = tcg_const_i32(ctx->ct.wbs);
         TCGv npc = tcg_const_tl(pc_next);
 
         gen_helper_call(cpu_env, ctx->ct.u.ctpr, wbs, npc);
-        tcg_gen_lookup_and_goto_ptr();
+        if (ctpr.tag == CTPR_TAG_DISP || ctpr.tag == CTPR_TAG_SDISP) {
+            /*
+             * The callee window and rotation state only depend on the
+             * caller TB flags and wbs, so the chained TB stays valid.
+             */
+            gen_goto_tb(ctx, TB_EXIT_IDX1, ctx->pc, ctpr.base);
+        } else {
+            tcg_gen_lookup_and_goto_ptr();
+        }
 
         tcg_temp_free(npc);
         tcg_temp_free_i32(wbs);
@@ -1100,21 +1246,11 @@ static inline void do_branch(DisasContext *ctx, target_ulong pc_next)
 
 static void e2k_tr_init_disas_context(DisasContextBase *db, CPUState *cs)
 {
-    static int version = -1;
     DisasContext *ctx = container_of(db, DisasContext, base);
     E2KCPU *cpu = E2K_CPU(cs);
     CPUE2KState *env = &cpu->env;
 
     ctx->version = env->version;
-
-    if (version != ctx->version) {
-        if (version > 0) {
-            // FIXME: can it happen?
-            e2k_todo(ctx, "reinitialize alc map");
-        }
-        alc_init(ctx);
-        version = ctx->version;
-    }
 }
 
 static bool e2k_tr_breakpoint_check(DisasContextBase *db, CPUState *cs,
@@ -1143,19 +1279,57 @@ static bool e2k_tr_breakpoint_check(DisasContextBase *db, CPUState *cs,
     }
 }
 
+/*
+ * wd.base only changes on calls, returns and exceptions, which all end the
+ * TB, so %rN slots are at constant offsets from these pointers.
+ */
+static void gen_window_ptrs(DisasContext *ctx)
+{
+    TCGv_i32 t0 = tcg_temp_new_i32();
+    TCGv_ptr t1 = tcg_temp_new_ptr();
+
+    ctx->wregs = tcg_temp_local_new_ptr();
+    ctx->wtags = tcg_temp_local_new_ptr();
+
+    tcg_gen_ext_i32_ptr(t1, e2k_cs.wd_base);
+    tcg_gen_add_ptr(ctx->wtags, cpu_env, t1);
+    tcg_gen_muli_i32(t0, e2k_cs.wd_base, sizeof(E2KQReg));
+    tcg_gen_ext_i32_ptr(t1, t0);
+    tcg_gen_add_ptr(ctx->wregs, cpu_env, t1);
+
+    tcg_temp_free_ptr(t1);
+    tcg_temp_free_i32(t0);
+}
+
 static void e2k_tr_tb_start(DisasContextBase *db, CPUState *cs)
 {
     DisasContext *ctx = container_of(db, DisasContext, base);
     E2KCPU *cpu = E2K_CPU(cs);
     CPUE2KState *env = &cpu->env;
+    uint64_t flags = ctx->base.tb->cs_base;
 
-    ctx->wd_size = DYNAMIC;
+    ctx->wd_size = extract64(flags, E2K_TB_WD_SIZE_OFF, E2K_TB_WD_SIZE_LEN);
     ctx->max_r = -1;
     ctx->max_r_src = -1;
     ctx->max_r_dst = -1;
-    ctx->bsize = DYNAMIC;
+    ctx->boff = extract64(flags, E2K_TB_BOFF_OFF, E2K_TB_BOFF_LEN);
+    ctx->bsize = extract64(flags, E2K_TB_BSIZE_OFF, E2K_TB_BSIZE_LEN);
     ctx->max_b = -1;
     ctx->max_b_cur = -1;
+    ctx->psize = extract64(flags, E2K_TB_PSIZE_OFF, E2K_TB_PSIZE_LEN);
+    memset(ctx->ctprs, 0, sizeof(ctx->ctprs));
+    ctx->fast_tags = !extract64(flags, E2K_TB_TAGS_OFF, E2K_TB_TAGS_LEN);
+    ctx->loop_kernel_tb = extract64(flags, E2K_TB_LOOP_KERNEL_OFF,
+        E2K_TB_LOOP_KERNEL_LEN);
+    ctx->loop_kernel = ctx->loop_kernel_tb;
+    ctx->lsr_dirty = false;
+
+    if (!ctx->fast_tags) {
+        /* try the fast path again in the next TB */
+        TCGv_i32 t0 = tcg_const_i32(0);
+        tcg_gen_st_i32(t0, cpu_env, offsetof(CPUE2KState, tags_full));
+        tcg_temp_free_i32(t0);
+    }
 
     tcg_gen_movi_i32(e2k_cs.ct_cond, 0);
 
@@ -1165,6 +1339,8 @@ static void e2k_tr_tb_start(DisasContextBase *db, CPUState *cs)
         gen_helper_break_restore_state(cpu_env);
         gen_set_label(l0);
     }
+
+    gen_window_ptrs(ctx);
 }
 
 static void e2k_tr_insn_start(DisasContextBase *db, CPUState *cs)
@@ -1183,6 +1359,9 @@ static void e2k_tr_insn_start(DisasContextBase *db, CPUState *cs)
     ctx->do_check_illtag = false;
     ctx->illtag = e2k_get_temp_i32(ctx);
     tcg_gen_movi_i32(ctx->illtag, 0);
+    if (ctx->fast_tags) {
+        ctx->zero_tag = e2k_get_const_i32(ctx, 0);
+    }
 }
 
 static void e2k_tr_translate_insn(DisasContextBase *db, CPUState *cs)
@@ -1198,18 +1377,12 @@ static void e2k_tr_translate_insn(DisasContextBase *db, CPUState *cs)
         gen_helper_syscall(cpu_env);
         tcg_gen_exit_tb(NULL, TB_EXIT_IDX0);
         break;
-    case E2K_SYSRET_ADDR: {
+    case E2K_SYSRET_ADDR:
         /* fake return from syscall handler */
-        TCGv_i32 t0 = tcg_const_i32(0);
-
         ctx->base.is_jmp = DISAS_NORETURN;
-        gen_helper_prep_return(e2k_cs.ctprs[2], cpu_env, t0);
-        gen_helper_return(cpu_env);
+        gen_helper_sysret(cpu_env);
         tcg_gen_exit_tb(NULL, TB_EXIT_IDX0);
-
-        tcg_temp_free_i32(t0);
         break;
-    }
     case E2K_SIGRET_ADDR:
         /* fake return from signal handler */
         gen_helper_signal_return(cpu_env);
@@ -1220,6 +1393,7 @@ static void e2k_tr_translate_insn(DisasContextBase *db, CPUState *cs)
         target_ulong pc_next;
 
         pc_next = do_decode(ctx, cs);
+        gen_tags_check(ctx);
         do_execute(ctx);
         do_checks(ctx);
         do_commit(ctx);
@@ -1310,9 +1484,6 @@ void e2k_tcg_initialize(void) {
         { &e2k_cs.ct_cond, offsetof(CPUE2KState, ct_cond), "cond" },
     };
 
-    static const struct { TCGv_i64 *ptr; int off; const char *name; } r64[] = {
-        { &e2k_cs.pregs, offsetof(CPUE2KState, pregs), "pregs" },
-    };
 
     static const struct { TCGv *ptr; int off; const char *name; } rtl[] = {
         { &e2k_cs.pc, offsetof(CPUE2KState, ip), "pc" },
@@ -1325,14 +1496,16 @@ void e2k_tcg_initialize(void) {
         *r32[i].ptr = tcg_global_mem_new_i32(cpu_env, r32[i].off, r32[i].name);
     }
 
-    for (i = 0; i < ARRAY_SIZE(r64); i++) {
-        *r64[i].ptr = tcg_global_mem_new_i64(cpu_env, r64[i].off, r64[i].name);
-    }
-
     for (i = 0; i < ARRAY_SIZE(rtl); i++) {
         *rtl[i].ptr = tcg_global_mem_new(cpu_env, rtl[i].off, rtl[i].name);
     }
 
+    for (i = 0; i < E2K_GR_COUNT; i++) {
+        snprintf(buf, ARRAY_SIZE(buf), "%%g%d", i);
+        e2k_cs.gregs[i] = tcg_global_mem_new_i64(cpu_env,
+            offsetof(CPUE2KState, regs[E2K_GR_BASE + i].lo), buf);
+    }
+
     for (i = 0; i < 3; i++) {
         snprintf(buf, ARRAY_SIZE(buf), "%%ctpr%d", i + 1);
         e2k_cs.ctprs[i] = tcg_global_mem_new_i64(cpu_env,
@@ -1365,4 +1538,6 @@ void e2k_tcg_initialize(void) {
         e2k_cs.aad_hi[i] = tcg_global_mem_new_i64(cpu_env,
             offsetof(CPUE2KState, aau.ds[i].hi), buf);
     }
+
+    alc_init();
 }
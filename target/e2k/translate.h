@@ -42,14 +42,14 @@ typedef struct CPUE2KStateTCG {
     TCGv_i32 ct_cond;
     TCGv_i32 is_bp; /* breakpoint flag */
     TCGv_i32 wdbl;
-    TCGv_i32 wd_base; /* holds wbs * 2 */
+    TCGv_i32 wd_base; /* physical index of %r0 */
     TCGv_i32 wd_size; /* holds wsz * 2 */
     TCGv_i32 boff; /* holds rbs * 2 */
     TCGv_i32 bsize; /* holds rsz * 2 + 2 */
     TCGv_i32 bcur; /* holds rcur * 2 */
-    TCGv_i64 pregs;
     TCGv_i32 psize; /* holds psz */
     TCGv_i32 pcur; /* holds pcur */
+    TCGv_i64 gregs[E2K_GR_COUNT]; /* %gN values, tags stay in env */
     /* lsr */
     TCGv_i32 lsr_lcnt;
     TCGv_i32 lsr_ecnt;
@@ -263,6 +263,22 @@ typedef struct {
     Alop alops[6];
 } Bundle;
 
+typedef enum {
+    REG_WINDOW, /* %rN */
+    REG_BASED,  /* %b[N] */
+    REG_GLOBAL, /* %gN */
+} RegKind;
+
+/*
+ * Register file operand. %rN and %gN are resolved at translation time,
+ * only %b[N] needs the rotation state.
+ */
+typedef struct {
+    RegKind kind;
+    int n;          /* N of %rN or %gN */
+    TCGv_i32 off;   /* offset of %b[N] from %r0, allocated by the caller */
+} Reg;
+
 typedef enum {
     AL_RESULT_NONE = 0,
 
@@ -296,9 +312,11 @@ typedef struct {
     bool poison;
     /* Is 32-bit op affected by wdbl  */
     bool dbl;
+    /* 128-bit value is staged in env->al_q[chan] instead of v64 and x64 */
+    bool vec;
     union {
         struct {
-            TCGv_i32 index;
+            Reg index;
             TCGv_i32 tag;
             union {
                 TCGv_i32 v32;
@@ -326,7 +344,7 @@ typedef struct {
 typedef struct {
     bool is_set;
     uint8_t dst;
-    TCGv_i32 index;
+    Reg index;
     TCGv_i32 tag;
     TCGv_i64 value;
 } AauResult;
@@ -349,6 +367,7 @@ typedef struct {
         target_ulong target;
         TCGv_i64 ctpr;
     } u;
+    int ctpr_index;
     int wbs;
     uint8_t cond_type;
     uint8_t psrc;
@@ -364,8 +383,27 @@ typedef struct DisasContext {
     uint8_t mas[6];
     bool loop_mode;
     TCGv_i32 is_epilogue;
+    /* &env->regs[wd.base] and &env->tags[wd.base] relative to env,
+       wd.base is constant within a TB */
+    TCGv_ptr wregs;
+    TCGv_ptr wtags;
+    /*
+     * Source tags are checked before the bundle is executed, a non-numeric
+     * one restarts the bundle in a TB with full tag tracking. Sources
+     * marked in src_checked are numeric for the rest of the bundle.
+     */
+    bool fast_tags;
+    unsigned long src_checked[BITS_TO_LONGS(256)];
+    /* zero tag shared by the sources of a bundle without tag tracking */
+    TCGv_i32 zero_tag;
     /* optional, can be NULL */
     TCGv_i32 mlock;
+    /* e2k_loop_kernel() was true at the TB start */
+    bool loop_kernel_tb;
+    /* e2k_loop_kernel() is still known to be true */
+    bool loop_kernel;
+    /* lsr may have been changed since the TB start */
+    bool lsr_dirty;
 
     int version;
     /* Force ILLOP for bad instruction format for cases where real CPU
@@ -374,7 +412,7 @@ typedef struct DisasContext {
 
     // Temporary values.
     TCGv_i32 t32[64];
-    TCGv_i64 t64[32];
+    TCGv_i64 t64[64];
     TCGv ttl[8];
     // Allocated temporary values count.
     int t32_len;
@@ -390,9 +428,11 @@ typedef struct DisasContext {
     int max_r;
     int max_r_src;
     int max_r_dst;
+    int boff;
     int bsize;
     int max_b;
     int max_b_cur;
+    int psize;
 
     TCGv_i64 cond[6];
     AlResult al_results[6];
@@ -401,6 +441,11 @@ typedef struct DisasContext {
     int aau_am[4];
     PlResult pl_results[3];
     ControlTransfer ct;
+    /*
+     * ctpr values known at translation time, loaded by disp in an earlier
+     * bundle of the TB. CTPR_TAG_NONE if not known.
+     */
+    E2KCtpr ctprs[3];
 } DisasContext;
 
 /* exception generated in translation time */
@@ -525,31 +570,22 @@ static inline void e2k_gen_save_cpu_state(DisasContext *ctx)
     e2k_gen_save_pc(ctx->pc);
 }
 
-static inline void e2k_gen_lcntex(TCGv_i32 ret)
+static inline void e2k_gen_lcntex(DisasContext *ctx, TCGv_i32 ret)
 {
-    tcg_gen_setcondi_i32(TCG_COND_EQ, ret, e2k_cs.lsr_lcnt, 0);
+    if (ctx->loop_kernel) {
+        tcg_gen_movi_i32(ret, 0);
+    } else {
+        tcg_gen_setcondi_i32(TCG_COND_EQ, ret, e2k_cs.lsr_lcnt, 0);
+    }
 }
 
-void e2k_gen_store_preg(int idx, TCGv_i32 val);
-
-void e2k_gen_reg_tag_read_i64(TCGv_i32 ret, TCGv_i32 idx);
-void e2k_gen_reg_tag_read_i32(TCGv_i32 ret, TCGv_i32 idx);
-void e2k_gen_reg_tag_write_i64(TCGv_i32 value, TCGv_i32 idx);
-void e2k_gen_reg_tag_write_i32(TCGv_i32 value, TCGv_i32 idx);
+void e2k_gen_store_preg(DisasContext *ctx, int idx, TCGv_i32 val);
+void e2k_gen_lsr_changed(DisasContext *ctx);
 
-static inline void e2k_gen_reg_tag_writei_i64(int value, TCGv_i32 idx)
-{
-    TCGv_i32 t0 = tcg_const_i32(value);
-    e2k_gen_reg_tag_write_i64(t0, idx);
-    tcg_temp_free_i32(t0);
-}
-
-static inline void e2k_gen_reg_tag_writei_i32(int value, TCGv_i32 idx)
-{
-    TCGv_i32 t0 = tcg_const_i32(value);
-    e2k_gen_reg_tag_write_i32(t0, idx);
-    tcg_temp_free_i32(t0);
-}
+void e2k_gen_reg_tag_read_i64(DisasContext *ctx, TCGv_i32 ret, Reg *reg);
+void e2k_gen_reg_tag_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg);
+void e2k_gen_reg_tag_write_i64(DisasContext *ctx, TCGv_i32 value, Reg *reg);
+void e2k_gen_reg_tag_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg);
 
 static inline void e2k_gen_reg_tag_extract_lo(TCGv_i32 ret, TCGv_i32 tags)
 {
@@ -564,42 +600,52 @@ static inline void e2k_gen_reg_tag_extract_hi(TCGv_i32 ret, TCGv_i32 tags)
 void e2k_gen_reg_tag_check_i64(TCGv_i32 ret, TCGv_i32 tag);
 void e2k_gen_reg_tag_check_i32(TCGv_i32 ret, TCGv_i32 tag);
 
-void e2k_gen_reg_index_from_wregi(TCGv_i32 ret, int idx);
-void e2k_gen_reg_index_from_bregi(TCGv_i32 ret, int idx);
-void e2k_gen_reg_index_from_gregi(TCGv_i32 ret, int idx);
-static inline void e2k_gen_reg_index(DisasContext *ctx, TCGv_i32 ret, uint8_t arg)
+void e2k_gen_reg_index_from_wregi(Reg *ret, int idx);
+void e2k_gen_reg_index_from_bregi(DisasContext *ctx, Reg *ret, int idx);
+void e2k_gen_reg_index_from_gregi(Reg *ret, int idx);
+static inline void e2k_gen_reg_index(DisasContext *ctx, Reg *ret, uint8_t arg)
 {
     if (IS_BASED(arg)) {
-        e2k_gen_reg_index_from_bregi(ret, GET_BASED(arg));
+        e2k_gen_reg_index_from_bregi(ctx, ret, GET_BASED(arg));
     } else if (IS_REGULAR(arg)) {
         e2k_gen_reg_index_from_wregi(ret, GET_REGULAR(arg));
     } else if (IS_GLOBAL(arg)) {
         e2k_gen_reg_index_from_gregi(ret, GET_GLOBAL(arg));
     } else {
+        e2k_gen_reg_index_from_wregi(ret, 0);
         e2k_tr_gen_exception(ctx, E2K_EXCP_ILLOPN);
     }
 }
 
-void e2k_gen_reg_read_i64(TCGv_i64 ret, TCGv_i32 idx);
-void e2k_gen_reg_read_i32(TCGv_i32 ret, TCGv_i32 idx);
-void e2k_gen_reg_write_i64(TCGv_i64 value, TCGv_i32 idx);
-void e2k_gen_reg_write_i32(TCGv_i32 value, TCGv_i32 idx);
-
-void e2k_gen_xreg_read_i64(TCGv_i64 ret, TCGv_i32 idx);
-void e2k_gen_xreg_read_i32(TCGv_i32 ret, TCGv_i32 idx);
-void e2k_gen_xreg_read16u_i32(TCGv_i32 ret, TCGv_i32 idx);
-void e2k_gen_xreg_write_i64(TCGv_i64 value, TCGv_i32 idx);
-void e2k_gen_xreg_write_i32(TCGv_i32 value, TCGv_i32 idx);
-void e2k_gen_xreg_write16u_i32(TCGv_i32 value, TCGv_i32 idx);
-
-void e2k_gen_preg_i32(TCGv_i32 ret, int reg);
+void e2k_gen_reg_read_i64(DisasContext *ctx, TCGv_i64 ret, Reg *reg);
+void e2k_gen_reg_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg);
+void e2k_gen_reg_write_i64(DisasContext *ctx, TCGv_i64 value, Reg *reg);
+void e2k_gen_reg_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg);
+
+void e2k_gen_xreg_read_i64(DisasContext *ctx, TCGv_i64 ret, Reg *reg);
+void e2k_gen_xreg_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg);
+void e2k_gen_xreg_read16u_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg);
+void e2k_gen_xreg_write_i64(DisasContext *ctx, TCGv_i64 value, Reg *reg);
+void e2k_gen_xreg_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg);
+void e2k_gen_xreg_write16u_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg);
+void e2k_gen_qreg_read(DisasContext *ctx, TCGv_vec ret, Reg *reg);
+void e2k_gen_qreg_write(DisasContext *ctx, TCGv_vec value, Reg *reg);
+
+void e2k_gen_preg_i32(DisasContext *ctx, TCGv_i32 ret, int reg);
 void e2k_gen_cond_i32(DisasContext *ctx, TCGv_i32 ret, uint8_t psrc);
 
-static inline void e2k_gen_is_loop_end_i32(TCGv_i32 ret)
+static inline void e2k_gen_is_loop_end_i32(DisasContext *ctx, TCGv_i32 ret)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-    TCGv_i32 t2 = tcg_temp_new_i32();
+    TCGv_i32 t0, t1, t2;
+
+    if (ctx->loop_kernel) {
+        tcg_gen_movi_i32(ret, 0);
+        return;
+    }
+
+    t0 = tcg_temp_new_i32();
+    t1 = tcg_temp_new_i32();
+    t2 = tcg_temp_new_i32();
 
     tcg_gen_setcondi_i32(TCG_COND_EQ, t0, e2k_cs.lsr_ecnt, 0);
     tcg_gen_setcondi_i32(TCG_COND_LTU, t1, e2k_cs.lsr_lcnt, 2);
@@ -611,13 +657,26 @@ static inline void e2k_gen_is_loop_end_i32(TCGv_i32 ret)
     tcg_temp_free_i32(t0);
 }
 
+/* %pcntN */
+static inline void e2k_gen_pcnt_i32(DisasContext *ctx, TCGv_i32 ret, int idx)
+{
+    if (ctx->loop_kernel) {
+        /* lsr.pcnt is zero */
+        tcg_gen_movi_i32(ret, 1);
+    } else {
+        tcg_gen_setcondi_i32(TCG_COND_LEU, ret, e2k_cs.lsr_pcnt, idx);
+    }
+}
+
 void e2k_decode_jmp(DisasContext *ctx);
 void e2k_stubs_commit(DisasContext *ctx);
 
-void alc_init(DisasContext *ctx);
+void alc_init(void);
 void e2k_alc_decode(DisasContext *ctx);
+void e2k_alc_gen_src_tags(DisasContext *ctx, TCGv_i32 ret);
 void e2k_alc_execute(DisasContext *ctx);
 void e2k_alc_commit(DisasContext *ctx);
+void e2k_gen_sm_check(TCGv addr, bool is_write, TCGLabel *fail);
 
 void e2k_aau_execute(DisasContext *ctx);
 void e2k_aau_commit(DisasContext *ctx);
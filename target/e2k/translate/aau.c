@@ -28,14 +28,14 @@ static void gen_aau_result(DisasContext *ctx, Mova *instr, TCGv_i64 dst,
 {
     AauResult *res = &ctx->aau_results[instr->chan];
     res->is_set = true;
-    res->index = e2k_get_temp_i32(ctx);
+    res->index.off = e2k_get_temp_i32(ctx);
     res->value = dst;
     res->tag = tag;
     if (IS_REGULAR(instr->dst)) {
         res->dst = instr->dst;
     } else {
         res->dst = 0;
-        e2k_gen_reg_index(ctx, res->index, instr->dst);
+        e2k_gen_reg_index(ctx, &res->index, instr->dst);
     }
 }
 
@@ -73,17 +73,60 @@ static void gen_checked_ld(DisasContext *ctx, Mova *instr, TCGv ptr)
     gen_aau_result(ctx, instr, dst, tag);
 }
 
-static inline void gen_mova_ptr(TCGv ret, Mova *instr)
+static inline size_t aau_area_offset(int chan, int area)
 {
-    TCGv_i32 t0 = tcg_const_i32(instr->chan);
-    TCGv_i32 t1 = tcg_const_i32(instr->area);
-    TCGv_i32 t2 = tcg_const_i32(instr->ind);
-    gen_helper_mova_ptr(ret, cpu_env, t0, t1, t2);
-    tcg_temp_free_i32(t2);
-    tcg_temp_free_i32(t1);
+    return chan < 2 ? offsetof(CPUE2KState, aau.pl.area[area])
+        : offsetof(CPUE2KState, aau.pr.area[area]);
+}
+
+/* ret = env + (index << shift) */
+static void gen_aau_index_ptr(TCGv_ptr ret, TCGv_i32 index, int shift)
+{
+    TCGv_i32 t0 = tcg_temp_new_i32();
+
+    tcg_gen_shli_i32(t0, index, shift);
+    tcg_gen_ext_i32_ptr(ret, t0);
+    tcg_gen_add_ptr(ret, cpu_env, ret);
+
     tcg_temp_free_i32(t0);
 }
 
+/* ret must be a local temp */
+static void gen_mova_ptr(TCGv ret, Mova *instr)
+{
+    size_t off = aau_area_offset(instr->chan, instr->area);
+    TCGLabel *l0 = gen_new_label();
+    TCGLabel *l1 = gen_new_label();
+    TCGv_i32 t0 = tcg_temp_new_i32();
+    TCGv_ptr t1 = tcg_temp_new_ptr();
+    TCGv t2 = tcg_temp_new();
+
+    QEMU_BUILD_BUG_ON(sizeof(E2KAad) != 16);
+
+    /* aad[pi.aad].base + cdi + pi.disp + ind */
+    tcg_gen_ld_i32(t0, cpu_env, off + offsetof(E2KAauAreaState, pi.lo));
+    tcg_gen_extract_i32(t0, t0, 15, 5);
+    gen_aau_index_ptr(t1, t0, 4);
+    tcg_gen_ld_tl(ret, t1, offsetof(CPUE2KState, aau.ds[0].lo));
+    tcg_gen_andi_tl(ret, ret, MAKE_64BIT_MASK(0, 48));
+    tcg_gen_ld32u_tl(t2, cpu_env, off + offsetof(E2KAauAreaState, cdi));
+    tcg_gen_add_tl(ret, ret, t2);
+    tcg_gen_ld32u_tl(t2, cpu_env, off + offsetof(E2KAauAreaState, pi.hi));
+    tcg_gen_add_tl(ret, ret, t2);
+    tcg_gen_addi_tl(ret, ret, instr->ind);
+
+    tcg_temp_free(t2);
+    tcg_temp_free_ptr(t1);
+    tcg_temp_free_i32(t0);
+
+    /* zero address if the page cannot be read */
+    e2k_gen_sm_check(ret, false, l0);
+    tcg_gen_br(l1);
+    gen_set_label(l0);
+    tcg_gen_movi_tl(ret, 0);
+    gen_set_label(l1);
+}
+
 static void gen_mova(DisasContext *ctx, Mova *instr)
 {
     /* branch in gen_checked_ld */
@@ -115,12 +158,32 @@ static void gen_mova(DisasContext *ctx, Mova *instr)
     tcg_temp_free(t5);
 }
 
-static inline void gen_aau_am(DisasContext *ctx, int chan, int area)
+/* cdi += incrs[pi.incr] << (pi.fmt - 1) if pi.fmt != 0 */
+static void gen_aau_am(DisasContext *ctx, int chan, int area)
 {
-    TCGv_i32 t0 = tcg_const_i32(chan);
-    TCGv_i32 t1 = tcg_const_i32(area);
-
-    gen_helper_aau_am(cpu_env, t0, t1);
+    size_t off = aau_area_offset(chan, area);
+    TCGv_i32 t0 = tcg_temp_new_i32();
+    TCGv_i32 t1 = tcg_temp_new_i32();
+    TCGv_i32 t2 = tcg_temp_new_i32();
+    TCGv_i32 zero = tcg_const_i32(0);
+    TCGv_ptr t3 = tcg_temp_new_ptr();
+
+    tcg_gen_ld_i32(t0, cpu_env, off + offsetof(E2KAauAreaState, pi.lo));
+    tcg_gen_extract_i32(t1, t0, 12, 3);
+    gen_aau_index_ptr(t3, t1, 2);
+    tcg_gen_ld_i32(t1, t3, offsetof(CPUE2KState, aau.incrs[0]));
+    tcg_gen_extract_i32(t0, t0, 25, 3);
+    tcg_gen_subi_i32(t2, t0, 1);
+    tcg_gen_andi_i32(t2, t2, 31);
+    tcg_gen_shl_i32(t1, t1, t2);
+    tcg_gen_movcond_i32(TCG_COND_EQ, t1, t0, zero, zero, t1);
+    tcg_gen_ld_i32(t2, cpu_env, off + offsetof(E2KAauAreaState, cdi));
+    tcg_gen_add_i32(t2, t2, t1);
+    tcg_gen_st_i32(t2, cpu_env, off + offsetof(E2KAauAreaState, cdi));
+
+    tcg_temp_free_ptr(t3);
+    tcg_temp_free_i32(zero);
+    tcg_temp_free_i32(t2);
     tcg_temp_free_i32(t1);
     tcg_temp_free_i32(t0);
 }
@@ -163,7 +226,8 @@ void e2k_aau_commit(DisasContext *ctx)
 
         if (res->is_set) {
             if (IS_REGULAR(res->dst)) {
-                e2k_gen_reg_index_from_wregi(res->index, GET_REGULAR(res->dst));
+                e2k_gen_reg_index_from_wregi(&res->index,
+                    GET_REGULAR(res->dst));
             }
         }
     }
@@ -173,8 +237,8 @@ void e2k_aau_commit(DisasContext *ctx)
 
         // TODO: aau.tags
         if (res->is_set) {
-            e2k_gen_reg_tag_write_i64(res->tag, res->index);
-            e2k_gen_reg_write_i64(res->value, res->index);
+            e2k_gen_reg_tag_write_i64(ctx, res->tag, &res->index);
+            e2k_gen_reg_write_i64(ctx, res->value, &res->index);
         }
     }
 
@@ -9,7 +9,35 @@
 #define glue3(a, b, c) glue(glue(a, b), c)
 #define glue4(a, b, c, d) glue(glue(a, b), glue(c, d))
 
-static int16_t alops_map[4][128][6];
+/*
+ * ALOP decode table, built once for every ISA version. The kind of a
+ * (version, opc2, opc1, chan) slot tells which extension fields select the
+ * operation, the full key is then looked up in an open addressing table.
+ */
+#define ALOP_VERSION_COUNT 8
+#define ALOP_HASH_BITS 16
+#define ALOP_HASH_SIZE (1 << ALOP_HASH_BITS)
+#define ALOP_KEY_EMPTY UINT32_MAX
+#define ALOP_EXT_NONE 0xffff
+
+typedef enum {
+    ALOP_KEY_UNUSED,
+    ALOP_KEY_ANY,
+    ALOP_KEY_OPCE1,
+    ALOP_KEY_CMP,
+    ALOP_KEY_CMP_C0,
+    ALOP_KEY_OPCE3,
+    ALOP_KEY_OPCE1_OPCE3,
+    ALOP_KEY_OPCE2,
+} AlopKeyKind;
+
+typedef struct {
+    uint32_t key;
+    int16_t index;
+} AlopHashEntry;
+
+static uint8_t alops_kind[ALOP_VERSION_COUNT][4][128][6];
+static AlopHashEntry alops_hash[ALOP_HASH_SIZE];
 
 typedef struct {
     TCGv_i32 tag;
@@ -27,6 +55,14 @@ typedef struct {
     TCGv_i32 value;
 } Src32;
 
+/* v5+ quad operand, value is used on hosts with 128-bit vectors */
+typedef struct {
+    TCGv_i32 tag;
+    TCGv_vec value;
+    TCGv_i64 lo;
+    TCGv_i64 hi;
+} Src128;
+
 typedef struct {
     DisasContext *ctx;
     int chan;
@@ -137,58 +173,123 @@ static inline Src80 get_temp_src80(Instr *instr)
     return t;
 }
 
+/*
+ * Without tag tracking a source checked before the bundle (see
+ * e2k_alc_gen_src_tags) is treated as a number, so the tag propagation
+ * code of the instruction folds away.
+ */
+static inline TCGv_i32 gen_src_tag(DisasContext *ctx, Reg *r, uint8_t arg,
+    bool is32)
+{
+    TCGv_i32 tag;
+
+    if (ctx->fast_tags && test_bit(arg, ctx->src_checked)) {
+        return ctx->zero_tag;
+    }
+
+    tag = e2k_get_temp_i32(ctx);
+    if (is32) {
+        e2k_gen_reg_tag_read_i32(ctx, tag, r);
+    } else {
+        e2k_gen_reg_tag_read_i64(ctx, tag, r);
+    }
+    return tag;
+}
+
 static inline void gen_reg_i80(DisasContext *ctx, Src80 *ret, uint8_t arg)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
+    Reg r = { .off = tcg_temp_new_i32() };
 
-    e2k_gen_reg_index(ctx, t0, arg);
-    ret->tag = e2k_get_temp_i32(ctx);
+    e2k_gen_reg_index(ctx, &r, arg);
+    ret->tag = gen_src_tag(ctx, &r, arg, false);
     ret->lo = e2k_get_temp_i64(ctx);
     ret->hi = e2k_get_temp_i32(ctx);
-    e2k_gen_reg_tag_read_i64(ret->tag, t0);
-    e2k_gen_reg_read_i64(ret->lo, t0);
-    e2k_gen_xreg_read16u_i32(ret->hi, t0);
-    tcg_temp_free_i32(t0);
+    e2k_gen_reg_read_i64(ctx, ret->lo, &r);
+    e2k_gen_xreg_read16u_i32(ctx, ret->hi, &r);
+    tcg_temp_free_i32(r.off);
 }
 
 static inline void gen_reg_i64(DisasContext *ctx, Src64 *ret, uint8_t arg)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
+    Reg r = { .off = tcg_temp_new_i32() };
 
-    e2k_gen_reg_index(ctx, t0, arg);
-    ret->tag = e2k_get_temp_i32(ctx);
+    e2k_gen_reg_index(ctx, &r, arg);
+    ret->tag = gen_src_tag(ctx, &r, arg, false);
     ret->value = e2k_get_temp_i64(ctx);
-    e2k_gen_reg_tag_read_i64(ret->tag, t0);
-    e2k_gen_reg_read_i64(ret->value, t0);
+    e2k_gen_reg_read_i64(ctx, ret->value, &r);
 
-    tcg_temp_free_i32(t0);
+    tcg_temp_free_i32(r.off);
 }
 
 static inline void gen_reg_i32(DisasContext *ctx, Src32 *ret, uint8_t arg)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
+    Reg r = { .off = tcg_temp_new_i32() };
 
-    e2k_gen_reg_index(ctx, t0, arg);
-    ret->tag = e2k_get_temp_i32(ctx);
+    e2k_gen_reg_index(ctx, &r, arg);
+    ret->tag = gen_src_tag(ctx, &r, arg, true);
     ret->value = e2k_get_temp_i32(ctx);
-    e2k_gen_reg_tag_read_i32(ret->tag, t0);
-    e2k_gen_reg_read_i32(ret->value, t0);
+    e2k_gen_reg_read_i32(ctx, ret->value, &r);
 
-    tcg_temp_free_i32(t0);
+    tcg_temp_free_i32(r.off);
+}
+
+static inline void gen_reg_i128(Instr *instr, Src128 *ret, uint8_t arg,
+    bool vec)
+{
+    DisasContext *ctx = instr->ctx;
+    Reg r = { .off = tcg_temp_new_i32() };
+
+    e2k_gen_reg_index(ctx, &r, arg);
+    ret->tag = gen_src_tag(ctx, &r, arg, false);
+    if (vec) {
+        ret->value = tcg_temp_new_vec(TCG_TYPE_V128);
+        e2k_gen_qreg_read(ctx, ret->value, &r);
+    } else {
+        ret->lo = e2k_get_temp_i64(ctx);
+        ret->hi = e2k_get_temp_i64(ctx);
+        e2k_gen_reg_read_i64(ctx, ret->lo, &r);
+        e2k_gen_xreg_read_i64(ctx, ret->hi, &r);
+    }
+
+    tcg_temp_free_i32(r.off);
+}
+
+/*
+ * Immediates and literals are zero-extended to 128 bits. The vector is built
+ * in the result slot of the channel, it is not written before the sources
+ * are read.
+ */
+static inline void gen_src128_from_i64(Instr *instr, Src128 *ret, Src64 src,
+    bool vec)
+{
+    ret->tag = src.tag;
+    if (vec) {
+        int ofs = offsetof(CPUE2KState, al_q[instr->chan]);
+        TCGv_i64 zero = tcg_const_i64(0);
+
+        tcg_gen_st_i64(src.value, cpu_env, ofs + offsetof(E2KQReg, lo));
+        tcg_gen_st_i64(zero, cpu_env, ofs + offsetof(E2KQReg, hi));
+        ret->value = tcg_temp_new_vec(TCG_TYPE_V128);
+        tcg_gen_ld_vec(ret->value, cpu_env, ofs);
+
+        tcg_temp_free_i64(zero);
+    } else {
+        ret->lo = src.value;
+        ret->hi = e2k_get_const_i64(instr->ctx, 0);
+    }
 }
 
-static inline void gen_temp_reg_write_i64_i32(TCGv_i64 lo, TCGv_i32 hi,
-    TCGv_ptr ptr)
+static inline void temp_free_src128(Src128 *t)
 {
-    tcg_gen_st_i64(lo, ptr, offsetof(E2KReg, f80.low));
-    tcg_gen_st16_i32(hi, ptr, offsetof(E2KReg, f80.high));
+    if (t->value != NULL) {
+        tcg_temp_free_vec(t->value);
+    }
 }
 
-static inline void gen_temp_reg_read_i64_i32(TCGv_ptr ptr, TCGv_i64 ret_lo,
-    TCGv_i32 ret_hi)
+/* Loads the sign/exponent of the last floatx80 helper result. */
+static inline void gen_f80_ret_hi(TCGv_i32 ret)
 {
-    tcg_gen_ld_i64(ret_lo, ptr, offsetof(E2KReg, f80.low));
-    tcg_gen_ld16u_i32(ret_hi, ptr, offsetof(E2KReg, f80.high));
+    tcg_gen_ld16u_i32(ret, cpu_env, offsetof(CPUE2KState, fx_hi));
 }
 
 static inline void gen_literal_i64(DisasContext *ctx, Src64 *ret, uint8_t arg)
@@ -351,6 +452,32 @@ static inline Src32 get_src2_i32(Instr *instr)
     return ret;
 }
 
+static inline Src128 get_src1_i128(Instr *instr, bool vec)
+{
+    Src128 ret = { 0 };
+
+    if (IS_IMM5(instr->src1)) {
+        gen_src128_from_i64(instr, &ret, get_src1_i64(instr), vec);
+    } else {
+        gen_reg_i128(instr, &ret, instr->src1, vec);
+    }
+
+    return ret;
+}
+
+static inline Src128 get_src2_i128(Instr *instr, bool vec)
+{
+    Src128 ret = { 0 };
+
+    if (IS_IMM4(instr->src2) || IS_LIT(instr->src2)) {
+        gen_src128_from_i64(instr, &ret, get_src2_i64(instr), vec);
+    } else {
+        gen_reg_i128(instr, &ret, instr->src2, vec);
+    }
+
+    return ret;
+}
+
 static inline Src64 get_src3_i64(Instr *instr)
 {
     Src64 ret = { 0 };
@@ -448,6 +575,24 @@ static inline void gen_dst_poison_i64(TCGv_i64 ret, TCGv_i64 value,
     tcg_temp_free_i64(zero);
 }
 
+/* Both halves of a quad register are poisoned. */
+static inline void gen_dst_poison_v128(TCGv_vec ret, TCGv_vec value,
+    TCGv_i32 tag)
+{
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_vec t1 = tcg_temp_new_vec(TCG_TYPE_V128);
+
+    tcg_gen_extu_i32_i64(t0, tag);
+    tcg_gen_setcondi_i64(TCG_COND_NE, t0, t0, 0);
+    tcg_gen_neg_i64(t0, t0);
+    tcg_gen_andi_i64(t0, t0, (1UL << 62) | (1 << 30));
+    tcg_gen_dup_i64_vec(MO_64, t1, t0);
+    tcg_gen_or_vec(MO_64, ret, value, t1);
+
+    tcg_temp_free_vec(t1);
+    tcg_temp_free_i64(t0);
+}
+
 static inline void gen_dst_poison_i32(TCGv_i32 ret, TCGv_i32 value,
     TCGv_i32 tag)
 {
@@ -475,8 +620,38 @@ static inline void set_al_result_reg80_tag(Instr *instr, TCGv_i64 lo,
         res->reg.tag = tag;
         res->reg.v64 = lo;
         res->reg.x32 = hi;
-        res->reg.index = get_temp_i32(instr);
-        e2k_gen_reg_index(instr->ctx, res->reg.index, dst);
+        res->reg.index.off = get_temp_i32(instr);
+        e2k_gen_reg_index(instr->ctx, &res->reg.index, dst);
+    }
+}
+
+/*
+ * A vector result is staged in env->al_q[chan] until the commit, local TCG
+ * temps only get 64-bit frame slots and a vector can not live across the
+ * branches in between.
+ */
+static inline void set_al_result_reg128_tag(Instr *instr, TCGv_vec value,
+    TCGv_i64 lo, TCGv_i64 hi, TCGv_i32 tag, bool poison)
+{
+    uint8_t dst = instr->dst;
+    AlResult *res = &instr->ctx->al_results[instr->chan];
+
+    res->poison = poison;
+    res->vec = value != NULL;
+    if (dst == 0xdf) {
+        res->type = AL_RESULT_NONE;
+    } else {
+        res->type = AL_RESULT_REG128;
+        res->reg.tag = tag;
+        if (res->vec) {
+            tcg_gen_st_vec(value, cpu_env,
+                offsetof(CPUE2KState, al_q[instr->chan]));
+        } else {
+            res->reg.v64 = lo;
+            res->reg.x64 = hi;
+        }
+        res->reg.index.off = get_temp_i32(instr);
+        e2k_gen_reg_index(instr->ctx, &res->reg.index, dst);
     }
 }
 
@@ -490,7 +665,6 @@ static inline void set_al_result_reg64_tag(Instr *instr,
     // TODO: %tst, %tc, %tcd
     if (arg == 0xdf) { /* %empty */
         res->type = AL_RESULT_NONE;
-        res->reg.index = NULL;
         res->reg.v64 = NULL;
         res->reg.tag = NULL;
     } else if ((arg & 0xfc) == 0xd0 && (arg & 3) != 0) {
@@ -503,8 +677,8 @@ static inline void set_al_result_reg64_tag(Instr *instr,
         res->type = AL_RESULT_REG64;
         res->reg.v64 = value;
         res->reg.tag = tag;
-        res->reg.index = e2k_get_temp_i32(instr->ctx);
-        e2k_gen_reg_index(instr->ctx, res->reg.index, arg);
+        res->reg.index.off = e2k_get_temp_i32(instr->ctx);
+        e2k_gen_reg_index(instr->ctx, &res->reg.index, arg);
     }
 }
 
@@ -526,7 +700,6 @@ static inline void set_al_result_reg32_tag(Instr *instr,
     // TODO: %tst, %tc, %tcd
     if (arg == 0xdf) { /* %empty */
         res->type = AL_RESULT_NONE;
-        res->reg.index = NULL;
         res->reg.v32 = NULL;
         res->reg.tag = NULL;
     } else if ((arg & 0xfc) == 0xd0 && (arg & 3) != 0) {
@@ -538,8 +711,8 @@ static inline void set_al_result_reg32_tag(Instr *instr,
         res->type = AL_RESULT_REG32;
         res->reg.v32 = value;
         res->reg.tag = tag;
-        res->reg.index = e2k_get_temp_i32(instr->ctx);
-        e2k_gen_reg_index(instr->ctx, res->reg.index, arg);
+        res->reg.index.off = e2k_get_temp_i32(instr->ctx);
+        e2k_gen_reg_index(instr->ctx, &res->reg.index, arg);
     }
 }
 
@@ -565,6 +738,13 @@ static inline void gen_al_result_i80(Instr *instr, TCGv_i64 lo, TCGv_i32 hi,
     set_al_result_reg80_tag(instr, lo, hi, tag, true);
 }
 
+static inline void gen_al_result_i128(Instr *instr, TCGv_vec value,
+    TCGv_i64 lo, TCGv_i64 hi, TCGv_i32 tag)
+{
+    gen_tag_check(instr, tag);
+    set_al_result_reg128_tag(instr, value, lo, hi, tag, true);
+}
+
 static inline void gen_al_result_i64(Instr *instr, TCGv_i64 dst, TCGv_i32 tag)
 {
     gen_tag_check(instr, tag);
@@ -679,11 +859,12 @@ static inline void gen_mrgc_i32(DisasContext *ctx, int chan, TCGv_i32 ret)
 
 static void gen_loop_mode_st(DisasContext *ctx, TCGLabel *l)
 {
-    if (ctx->loop_mode) {
+    /* stores are never masked in the loop kernel */
+    if (ctx->loop_mode && !ctx->loop_kernel) {
         TCGLabel *l0 = gen_new_label();
         TCGv_i32 t0 = tcg_temp_new_i32();
         tcg_gen_brcondi_i32(TCG_COND_NE, e2k_cs.lsr_pcnt, 0, l);
-        e2k_gen_is_loop_end_i32(t0);
+        e2k_gen_is_loop_end_i32(ctx, t0);
         tcg_gen_brcondi_i32(TCG_COND_EQ, t0, 0, l0);
         tcg_gen_brcondi_i32(TCG_COND_EQ, e2k_cs.lsr_strmd, 0, l);
         tcg_gen_subi_i32(e2k_cs.lsr_strmd, e2k_cs.lsr_strmd, 1);
@@ -1276,25 +1457,15 @@ static void gen_fcmp_i64(TCGv_i64 ret, int opc, TCGv_i64 src1, TCGv_i64 src2)
 
 static void gen_fcmp_f80(TCGv_i64 ret, int opc, Src80 src1, Src80 src2)
 {
-    void (*f)(TCGv_i64, TCGv_env, TCGv_ptr, TCGv_ptr) = 0;
+    void (*f)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32) = 0;
     TCGv_i64 dst = tcg_temp_new_i64();
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-    TCGv_ptr t1 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    tcg_gen_addi_ptr(t1, cpu_env, offsetof(CPUE2KState, t1.f80));
-
-    gen_temp_reg_write_i64_i32(src1.lo, src1.hi, t0);
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t1);
 
     GENERATE_FCMP_SWITCH_TABLE(f, opc, 0, gen_helper_, fx, x)
 
-    (*f)(dst, cpu_env, t0, t1);
+    (*f)(dst, cpu_env, src1.lo, src1.hi, src2.lo, src2.hi);
 
     tcg_gen_setcondi_i64(TCG_COND_NE, ret, dst, 0);
 
-    tcg_temp_free_ptr(t1);
-    tcg_temp_free_ptr(t0);
     tcg_temp_free_i64(dst);
 }
 
@@ -1630,6 +1801,11 @@ static inline void gen_rw_i64(Instr *instr)
     gen_tag_check(instr, s2.tag);
     gen_helper_state_reg_write_i64(cpu_env, t0, s2.value);
     tcg_temp_free_i32(t0);
+
+    if (instr->dst == 0x83) {
+        /* %lsr */
+        e2k_gen_lsr_changed(instr->ctx);
+    }
 }
 
 static inline void gen_rw_i32(Instr *instr)
@@ -1640,6 +1816,11 @@ static inline void gen_rw_i32(Instr *instr)
     gen_tag_check(instr, s2.tag);
     gen_helper_state_reg_write_i32(cpu_env, t0, s2.value);
     tcg_temp_free_i32(t0);
+
+    if (instr->dst == 0x83) {
+        /* %lsr */
+        e2k_gen_lsr_changed(instr->ctx);
+    }
 }
 
 static void gen_sxt(DisasContext *ctx, Instr *instr)
@@ -1717,22 +1898,13 @@ static inline bool gen_ld_mas_mod(DisasContext *ctx, Instr *instr, uint8_t mod)
     switch (mod) {
     case 3:
         if (is_chan_25(instr->chan)) {
-            // TODO: DAM
-            if (ctx->mlock == NULL) {
-                ctx->mlock = e2k_get_temp_i32(ctx);
-                /* always go to fixing code */
-                tcg_gen_movi_i32(ctx->mlock, 1);
-            }
+            /* check load, see gen_dam_check */
             return true;
         }
         break;
     case 4:
-        if (instr->sm && is_chan_03(instr->chan)) {
-            // TODO: DAM
-            /* always ignore lock load */
-            return false;
-        } else if (!instr->sm && (is_chan_25(instr->chan) || is_chan_03(instr->chan))) {
-            // TODO
+        if (is_chan_03(instr->chan) || (!instr->sm && is_chan_25(instr->chan))) {
+            /* lock load, see gen_dam_lock */
             return true;
         }
         break;
@@ -1795,6 +1967,82 @@ static MemOp gen_mas(Instr *instr, MemOp memop)
     return memop;
 }
 
+static inline int ld_mas_mod(Instr *instr)
+{
+    if ((instr->mas & 7) == 7 || instr->opc1 < 0x64 || 0x68 <= instr->opc1) {
+        return 0;
+    }
+
+    return instr->mas & 7;
+}
+
+static inline bool is_dam_lock(Instr *instr)
+{
+    return ld_mas_mod(instr) == 4;
+}
+
+static inline bool is_dam_check(Instr *instr)
+{
+    return ld_mas_mod(instr) == 3 && is_chan_25(instr->chan);
+}
+
+static void gen_dam_lock(Instr *instr, TCGv addr, TCGv_i64 value,
+    MemOp memop)
+{
+    TCGv_i32 t0 = tcg_const_i32(memop_size(memop));
+    TCGv_i32 t1 = tcg_const_i32(instr->dst);
+
+    gen_helper_dam_lock_addr(cpu_env, addr, value, t0, t1);
+
+    tcg_temp_free_i32(t1);
+    tcg_temp_free_i32(t0);
+}
+
+static void gen_dam_check(Instr *instr, TCGv addr, TCGv_i64 value,
+    MemOp memop)
+{
+    TCGv_i32 t0 = tcg_const_i32(memop_size(memop));
+    TCGv_i32 t1 = tcg_const_i32(instr->dst);
+    TCGv_i32 t2 = tcg_temp_new_i32();
+
+    /* ctx->mlock is initialized in gen_alop */
+    gen_helper_dam_unlock_addr(t2, cpu_env, addr, value, t0, t1);
+    tcg_gen_or_i32(instr->ctx->mlock, instr->ctx->mlock, t2);
+
+    tcg_temp_free_i32(t2);
+    tcg_temp_free_i32(t1);
+    tcg_temp_free_i32(t0);
+}
+
+/*
+ * Branches to FAIL if a speculative access to ADDR must not be performed.
+ * The page of the last successful probe is cached in env, so the helper
+ * is only called for the first access to a page.
+ */
+void e2k_gen_sm_check(TCGv addr, bool is_write, TCGLabel *fail)
+{
+    TCGLabel *l0 = gen_new_label();
+    TCGv t0 = tcg_temp_new();
+    TCGv t1 = tcg_temp_new();
+    TCGv_i32 t2 = tcg_temp_new_i32();
+
+    tcg_gen_andi_tl(t0, addr, TARGET_PAGE_MASK);
+    tcg_gen_ld_tl(t1, cpu_env, is_write ? offsetof(CPUE2KState, sm_wpage)
+        : offsetof(CPUE2KState, sm_rpage));
+    tcg_gen_brcond_tl(TCG_COND_EQ, t0, t1, l0);
+    if (is_write) {
+        gen_helper_probe_write_access(t2, cpu_env, addr);
+    } else {
+        gen_helper_probe_read_access(t2, cpu_env, addr);
+    }
+    tcg_gen_brcondi_i32(TCG_COND_EQ, t2, 0, fail);
+    gen_set_label(l0);
+
+    tcg_temp_free_i32(t2);
+    tcg_temp_free(t1);
+    tcg_temp_free(t0);
+}
+
 static void gen_ld(Instr *instr, MemOp memop)
 {
     TCGv_i32 tag = get_temp_i32(instr);
@@ -1817,22 +2065,26 @@ static void gen_ld(Instr *instr, MemOp memop)
         tcg_gen_add_i64(t0, s1.value, s2.value);
 
         if (instr->sm) {
-            TCGv_i32 t1 = tcg_temp_new_i32();
+            e2k_gen_sm_check(t0, false, l0);
+        }
 
-            gen_helper_probe_read_access(t1, cpu_env, t0);
-            tcg_gen_brcondi_i32(TCG_COND_EQ, t1, 1, l0);
+        tcg_gen_qemu_ld_i64(dst, t0, instr->ctx->mmuidx, memop);
+
+        if (instr->sm) {
+            tcg_gen_br(l1);
+            gen_set_label(l0);
             tcg_gen_movi_i32(tag, E2K_TAG_NON_NUMBER64);
             tcg_gen_movi_i64(dst, E2K_LD_RESULT_INVALID);
-            tcg_gen_br(l1);
-
-            tcg_temp_free_i32(t1);
         }
 
-        gen_set_label(l0);
-        tcg_gen_qemu_ld_i64(dst, t0, instr->ctx->mmuidx, memop);
-
         gen_set_label(l1);
 
+        if (is_dam_lock(instr)) {
+            gen_dam_lock(instr, t0, dst, memop);
+        } else if (is_dam_check(instr)) {
+            gen_dam_check(instr, t0, dst, memop);
+        }
+
         tcg_temp_free_i64(t0);
     }
 
@@ -1858,10 +2110,7 @@ static void gen_ld(Instr *instr, MemOp memop)
             tcg_gen_add_i64(t0, s1.value, s2.value); \
             \
             if (instr->sm) { \
-                TCGv_i32 t1 = tcg_temp_new_i32(); \
-                gen_helper_probe_write_access(t1, cpu_env, t0); \
-                tcg_gen_brcondi_i32(TCG_COND_EQ, t1, 0, l0); \
-                tcg_temp_free_i32(t1); \
+                e2k_gen_sm_check(t0, true, l0); \
             } \
             \
             glue(tcg_gen_qemu_st_i, S)(s4.value, t0, instr->ctx->mmuidx, memop); \
@@ -1921,102 +2170,56 @@ static inline void gen_movxc(Instr *instr)
 
 static inline void gen_fstofx(Src80 *ret, TCGv_i32 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    gen_helper_fstofx(t0, cpu_env, src2);
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fstofx(ret->lo, cpu_env, src2);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_istofx(Src80 *ret, TCGv_i32 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    gen_helper_istofx(t0, cpu_env, src2);
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-    tcg_temp_free_ptr(t0);
+    gen_helper_istofx(ret->lo, cpu_env, src2);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_fdtofx(Src80 *ret, TCGv_i64 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_helper_fdtofx(t0, cpu_env, src2);
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fdtofx(ret->lo, cpu_env, src2);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_idtofx(Src80 *ret, TCGv_i64 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_helper_idtofx(t0, cpu_env, src2);
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-    tcg_temp_free_ptr(t0);
+    gen_helper_idtofx(ret->lo, cpu_env, src2);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_fxtofs(TCGv_i32 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtofs(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtofs(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_fxtois(TCGv_i32 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtois(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtois(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_fxtoistr(TCGv_i32 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtoistr(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtoistr(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_fxtofd(TCGv_i64 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtofd(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtofd(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_fxtoid(TCGv_i64 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtoid(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtoid(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_fxtoidtr(TCGv_i64 ret, Src80 src2)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0));
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t0);
-    gen_helper_fxtoidtr(ret, cpu_env, t0);
-    tcg_temp_free_ptr(t0);
+    gen_helper_fxtoidtr(ret, cpu_env, src2.lo, src2.hi);
 }
 
 static inline void gen_shli2_i64(TCGv_i64 rl, TCGv_i64 rh, TCGv_i64 l,
@@ -2040,25 +2243,355 @@ static inline void gen_shli2_i64(TCGv_i64 rl, TCGv_i64 rh, TCGv_i64 l,
     }
 }
 
-static inline void gen_shri2_i64(TCGv_i64 rl, TCGv_i64 rh, TCGv_i64 l,
-    TCGv_i64 h, int i)
-{
-    if (i < 64) {
-        TCGv_i64 t0 = tcg_temp_new_i64();
-        TCGv_i64 t1 = tcg_temp_new_i64();
-        tcg_gen_shli_i64(t0, h, 64 - i);
-        tcg_gen_shri_i64(t1, l, i);
-        tcg_gen_or_i64(rl, t1, t0);
-        tcg_gen_shri_i64(rh, h, i);
-        tcg_temp_free_i64(t1);
-        tcg_temp_free_i64(t0);
-    } else if (i < 128) {
-        tcg_gen_shri_i64(rl, h, i - 64);
-        tcg_gen_movi_i64(rh, 0);
-    } else {
-        tcg_gen_movi_i64(rl, 0);
-        tcg_gen_movi_i64(rh, 0);
+static inline void gen_shri2_i64(TCGv_i64 rl, TCGv_i64 rh, TCGv_i64 l,
+    TCGv_i64 h, int i)
+{
+    if (i < 64) {
+        TCGv_i64 t0 = tcg_temp_new_i64();
+        TCGv_i64 t1 = tcg_temp_new_i64();
+        tcg_gen_shli_i64(t0, h, 64 - i);
+        tcg_gen_shri_i64(t1, l, i);
+        tcg_gen_or_i64(rl, t1, t0);
+        tcg_gen_shri_i64(rh, h, i);
+        tcg_temp_free_i64(t1);
+        tcg_temp_free_i64(t0);
+    } else if (i < 128) {
+        tcg_gen_shri_i64(rl, h, i - 64);
+        tcg_gen_movi_i64(rh, 0);
+    } else {
+        tcg_gen_movi_i64(rl, 0);
+        tcg_gen_movi_i64(rh, 0);
+    }
+}
+
+/*
+ * Packed integer operations are lowered to SWAR sequences on i64 instead of
+ * per-lane helper loops. vece selects the lane size (MO_8, MO_16 or MO_32).
+ */
+
+static void gen_lane_add_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 a,
+    TCGv_i64 b)
+{
+    switch (vece) {
+    case MO_8: tcg_gen_vec_add8_i64(ret, a, b); break;
+    case MO_16: tcg_gen_vec_add16_i64(ret, a, b); break;
+    case MO_32: tcg_gen_vec_add32_i64(ret, a, b); break;
+    default: g_assert_not_reached(); break;
+    }
+}
+
+static void gen_lane_sub_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 a,
+    TCGv_i64 b)
+{
+    switch (vece) {
+    case MO_8: tcg_gen_vec_sub8_i64(ret, a, b); break;
+    case MO_16: tcg_gen_vec_sub16_i64(ret, a, b); break;
+    case MO_32: tcg_gen_vec_sub32_i64(ret, a, b); break;
+    default: g_assert_not_reached(); break;
+    }
+}
+
+/* Expands the sign bit of each lane into a whole lane mask. */
+static void gen_lane_mask_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 src)
+{
+    int bits = 8 << vece;
+
+    tcg_gen_shri_i64(ret, src, bits - 1);
+    tcg_gen_andi_i64(ret, ret, dup_const(vece, 1));
+    tcg_gen_muli_i64(ret, ret, MAKE_64BIT_MASK(0, bits));
+}
+
+/* Sets the sign bit of each lane of ret if a < b in that lane. */
+static void gen_lane_lt_i64(unsigned vece, bool sign, TCGv_i64 ret,
+    TCGv_i64 a, TCGv_i64 b)
+{
+    TCGv_i64 x = tcg_temp_new_i64();
+    TCGv_i64 y = tcg_temp_new_i64();
+    TCGv_i64 t0 = tcg_temp_new_i64();
+
+    if (sign) {
+        /* biasing by the sign bit turns a signed compare into unsigned */
+        uint64_t h = dup_const(vece, 1ull << ((8 << vece) - 1));
+        tcg_gen_xori_i64(x, a, h);
+        tcg_gen_xori_i64(y, b, h);
+    } else {
+        tcg_gen_mov_i64(x, a);
+        tcg_gen_mov_i64(y, b);
+    }
+    /* lt = (~x & y) | (~(x ^ y) & (x - y)) */
+    gen_lane_sub_i64(vece, t0, x, y);
+    tcg_gen_eqv_i64(ret, x, y);
+    tcg_gen_and_i64(t0, t0, ret);
+    tcg_gen_andc_i64(ret, y, x);
+    tcg_gen_or_i64(ret, ret, t0);
+
+    tcg_temp_free_i64(t0);
+    tcg_temp_free_i64(y);
+    tcg_temp_free_i64(x);
+}
+
+static void gen_pcmpeq_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 a,
+    TCGv_i64 b)
+{
+    uint64_t l = dup_const(vece, MAKE_64BIT_MASK(0, (8 << vece) - 1));
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+
+    /* the sign bit of a lane of t1 is set if the lane of a ^ b is not 0 */
+    tcg_gen_xor_i64(t0, a, b);
+    tcg_gen_andi_i64(t1, t0, l);
+    tcg_gen_addi_i64(t1, t1, l);
+    tcg_gen_or_i64(t1, t1, t0);
+    tcg_gen_not_i64(t1, t1);
+    gen_lane_mask_i64(vece, ret, t1);
+
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_pcmpgt_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 a,
+    TCGv_i64 b)
+{
+    TCGv_i64 t0 = tcg_temp_new_i64();
+
+    gen_lane_lt_i64(vece, true, t0, b, a);
+    gen_lane_mask_i64(vece, ret, t0);
+
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_pminmax_i64(unsigned vece, bool sign, bool max,
+    TCGv_i64 ret, TCGv_i64 a, TCGv_i64 b)
+{
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+
+    gen_lane_lt_i64(vece, sign, t0, a, b);
+    gen_lane_mask_i64(vece, t0, t0);
+    /* ret = t0 ? (max ? b : a) : (max ? a : b) */
+    tcg_gen_xor_i64(t1, a, b);
+    tcg_gen_and_i64(t1, t1, t0);
+    tcg_gen_xor_i64(ret, max ? a : b, t1);
+
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_padds_i64(unsigned vece, bool sub, TCGv_i64 ret,
+    TCGv_i64 a, TCGv_i64 b)
+{
+    uint64_t l = dup_const(vece, MAKE_64BIT_MASK(0, (8 << vece) - 1));
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+    TCGv_i64 t2 = tcg_temp_new_i64();
+
+    if (sub) {
+        gen_lane_sub_i64(vece, t0, a, b);
+        /* overflow if signs of a and b differ and the sign of a changed */
+        tcg_gen_xor_i64(t1, a, b);
+        tcg_gen_xor_i64(t2, a, t0);
+        tcg_gen_and_i64(t1, t1, t2);
+    } else {
+        gen_lane_add_i64(vece, t0, a, b);
+        /* overflow if the result sign differs from the signs of a and b */
+        tcg_gen_xor_i64(t1, t0, a);
+        tcg_gen_xor_i64(t2, t0, b);
+        tcg_gen_and_i64(t1, t1, t2);
+    }
+    gen_lane_mask_i64(vece, t1, t1);
+    /* saturated value is MIN for negative a and MAX otherwise */
+    gen_lane_mask_i64(vece, t2, a);
+    tcg_gen_xori_i64(t2, t2, l);
+    tcg_gen_xor_i64(t2, t2, t0);
+    tcg_gen_and_i64(t2, t2, t1);
+    tcg_gen_xor_i64(ret, t0, t2);
+
+    tcg_temp_free_i64(t2);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_paddus_i64(unsigned vece, bool sub, TCGv_i64 ret,
+    TCGv_i64 a, TCGv_i64 b)
+{
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+    TCGv_i64 t2 = tcg_temp_new_i64();
+
+    if (sub) {
+        /* clamp lanes with borrow to zero */
+        gen_lane_sub_i64(vece, t0, a, b);
+        gen_lane_lt_i64(vece, false, t1, a, b);
+        gen_lane_mask_i64(vece, t1, t1);
+        tcg_gen_andc_i64(ret, t0, t1);
+    } else {
+        /* carry = (a & b) | ((a | b) & ~(a + b)), clamp to all ones */
+        gen_lane_add_i64(vece, t0, a, b);
+        tcg_gen_or_i64(t1, a, b);
+        tcg_gen_andc_i64(t1, t1, t0);
+        tcg_gen_and_i64(t2, a, b);
+        tcg_gen_or_i64(t1, t1, t2);
+        gen_lane_mask_i64(vece, t1, t1);
+        tcg_gen_or_i64(ret, t0, t1);
+    }
+
+    tcg_temp_free_i64(t2);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_pavgu_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 a,
+    TCGv_i64 b)
+{
+    uint64_t l = dup_const(vece, MAKE_64BIT_MASK(0, (8 << vece) - 1));
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+
+    /* (a + b + 1) >> 1 == (a | b) - ((a ^ b) >> 1), never borrows */
+    tcg_gen_xor_i64(t0, a, b);
+    tcg_gen_shri_i64(t0, t0, 1);
+    tcg_gen_andi_i64(t0, t0, l);
+    tcg_gen_or_i64(t1, a, b);
+    tcg_gen_sub_i64(ret, t1, t0);
+
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+static void gen_pshift_i64(unsigned vece, bool left, bool arith,
+    TCGv_i64 ret, TCGv_i64 a, TCGv_i64 b)
+{
+    int bits = 8 << vece;
+    TCGv_i64 t0 = tcg_const_i64(arith ? bits - 1 : bits);
+    TCGv_i64 t1 = tcg_const_i64(MAKE_64BIT_MASK(0, bits));
+    TCGv_i64 t2 = tcg_temp_new_i64();
+
+    /* larger counts shift in zeros or the sign in every lane */
+    tcg_gen_umin_i64(t0, b, t0);
+    if (left) {
+        tcg_gen_shl_i64(t2, a, t0);
+        tcg_gen_shl_i64(t1, t1, t0);
+        tcg_gen_andi_i64(t1, t1, MAKE_64BIT_MASK(0, bits));
+    } else {
+        tcg_gen_shr_i64(t2, a, t0);
+        tcg_gen_shr_i64(t1, t1, t0);
+    }
+    /* drop bits moved across lane boundaries */
+    tcg_gen_muli_i64(t1, t1, dup_const(vece, 1));
+    tcg_gen_and_i64(ret, t2, t1);
+    if (arith) {
+        /* sign extend from the shifted sign bit: (x ^ m) - m */
+        tcg_gen_movi_i64(t1, 1ull << (bits - 1));
+        tcg_gen_shr_i64(t1, t1, t0);
+        tcg_gen_muli_i64(t1, t1, dup_const(vece, 1));
+        tcg_gen_xor_i64(ret, ret, t1);
+        gen_lane_sub_i64(vece, ret, ret, t1);
+    }
+
+    tcg_temp_free_i64(t2);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+/* Spreads the lanes of the low half of src into every other lane. */
+static void gen_lane_spread_i64(unsigned vece, TCGv_i64 ret, TCGv_i64 src)
+{
+    tcg_gen_ext32u_i64(ret, src);
+    if (vece < MO_32) {
+        TCGv_i64 t0 = tcg_temp_new_i64();
+        int i;
+
+        for (i = MO_16; i >= (int) vece; i--) {
+            int shift = 8 << i;
+            tcg_gen_shli_i64(t0, ret, shift);
+            tcg_gen_or_i64(ret, ret, t0);
+            tcg_gen_andi_i64(ret, ret, dup_const(i + 1,
+                MAKE_64BIT_MASK(0, shift)));
+        }
+        tcg_temp_free_i64(t0);
+    }
+}
+
+static void gen_punpck_i64(unsigned vece, bool high, TCGv_i64 ret,
+    TCGv_i64 a, TCGv_i64 b)
+{
+    TCGv_i64 t0 = tcg_temp_new_i64();
+    TCGv_i64 t1 = tcg_temp_new_i64();
+
+    /* odd lanes come from a, even lanes from b */
+    if (high) {
+        tcg_gen_shri_i64(t0, a, 32);
+        tcg_gen_shri_i64(t1, b, 32);
+    } else {
+        tcg_gen_mov_i64(t0, a);
+        tcg_gen_mov_i64(t1, b);
+    }
+    gen_lane_spread_i64(vece, t0, t0);
+    gen_lane_spread_i64(vece, t1, t1);
+    tcg_gen_shli_i64(t0, t0, 8 << vece);
+    tcg_gen_or_i64(ret, t0, t1);
+
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
+#define IMPL_GEN_PACKED(NAME, IMPL, ...) \
+    static void NAME(TCGv_i64 ret, TCGv_i64 a, TCGv_i64 b) \
+    { \
+        IMPL(__VA_ARGS__, ret, a, b); \
     }
+
+IMPL_GEN_PACKED(gen_pcmpeqb, gen_pcmpeq_i64, MO_8)
+IMPL_GEN_PACKED(gen_pcmpeqh, gen_pcmpeq_i64, MO_16)
+IMPL_GEN_PACKED(gen_pcmpeqw, gen_pcmpeq_i64, MO_32)
+IMPL_GEN_PACKED(gen_pcmpgtb, gen_pcmpgt_i64, MO_8)
+IMPL_GEN_PACKED(gen_pcmpgth, gen_pcmpgt_i64, MO_16)
+IMPL_GEN_PACKED(gen_pcmpgtw, gen_pcmpgt_i64, MO_32)
+IMPL_GEN_PACKED(gen_pminub, gen_pminmax_i64, MO_8, false, false)
+IMPL_GEN_PACKED(gen_pminsb, gen_pminmax_i64, MO_8, true, false)
+IMPL_GEN_PACKED(gen_pminuh, gen_pminmax_i64, MO_16, false, false)
+IMPL_GEN_PACKED(gen_pminsh, gen_pminmax_i64, MO_16, true, false)
+IMPL_GEN_PACKED(gen_pminuw, gen_pminmax_i64, MO_32, false, false)
+IMPL_GEN_PACKED(gen_pminsw, gen_pminmax_i64, MO_32, true, false)
+IMPL_GEN_PACKED(gen_pmaxub, gen_pminmax_i64, MO_8, false, true)
+IMPL_GEN_PACKED(gen_pmaxsb, gen_pminmax_i64, MO_8, true, true)
+IMPL_GEN_PACKED(gen_pmaxuh, gen_pminmax_i64, MO_16, false, true)
+IMPL_GEN_PACKED(gen_pmaxsh, gen_pminmax_i64, MO_16, true, true)
+IMPL_GEN_PACKED(gen_pmaxuw, gen_pminmax_i64, MO_32, false, true)
+IMPL_GEN_PACKED(gen_pmaxsw, gen_pminmax_i64, MO_32, true, true)
+IMPL_GEN_PACKED(gen_paddsb, gen_padds_i64, MO_8, false)
+IMPL_GEN_PACKED(gen_paddsh, gen_padds_i64, MO_16, false)
+IMPL_GEN_PACKED(gen_psubsb, gen_padds_i64, MO_8, true)
+IMPL_GEN_PACKED(gen_psubsh, gen_padds_i64, MO_16, true)
+IMPL_GEN_PACKED(gen_paddusb, gen_paddus_i64, MO_8, false)
+IMPL_GEN_PACKED(gen_paddush, gen_paddus_i64, MO_16, false)
+IMPL_GEN_PACKED(gen_psubusb, gen_paddus_i64, MO_8, true)
+IMPL_GEN_PACKED(gen_psubush, gen_paddus_i64, MO_16, true)
+IMPL_GEN_PACKED(gen_pavgusb, gen_pavgu_i64, MO_8)
+IMPL_GEN_PACKED(gen_pavgush, gen_pavgu_i64, MO_16)
+IMPL_GEN_PACKED(gen_psllh, gen_pshift_i64, MO_16, true, false)
+IMPL_GEN_PACKED(gen_psllw, gen_pshift_i64, MO_32, true, false)
+IMPL_GEN_PACKED(gen_psrlh, gen_pshift_i64, MO_16, false, false)
+IMPL_GEN_PACKED(gen_psrlw, gen_pshift_i64, MO_32, false, false)
+IMPL_GEN_PACKED(gen_psrah, gen_pshift_i64, MO_16, false, true)
+IMPL_GEN_PACKED(gen_psraw, gen_pshift_i64, MO_32, false, true)
+IMPL_GEN_PACKED(gen_punpcklbh, gen_punpck_i64, MO_8, false)
+IMPL_GEN_PACKED(gen_punpcklhw, gen_punpck_i64, MO_16, false)
+IMPL_GEN_PACKED(gen_punpcklwd, gen_punpck_i64, MO_32, false)
+IMPL_GEN_PACKED(gen_punpckhbh, gen_punpck_i64, MO_8, true)
+IMPL_GEN_PACKED(gen_punpckhhw, gen_punpck_i64, MO_16, true)
+IMPL_GEN_PACKED(gen_punpckhwd, gen_punpck_i64, MO_32, true)
+
+static void gen_pcmpeqd(TCGv_i64 ret, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_setcond_i64(TCG_COND_EQ, ret, a, b);
+    tcg_gen_neg_i64(ret, ret);
+}
+
+static void gen_pcmpgtd(TCGv_i64 ret, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_setcond_i64(TCG_COND_GT, ret, a, b);
+    tcg_gen_neg_i64(ret, ret);
 }
 
 static inline void gen_psllql(TCGv_i64 ret, TCGv_i64 src1,
@@ -2228,12 +2761,12 @@ static void gen_aasti_incr(DisasContext *ctx, Instr *instr)
     TCGLabel *l0 = gen_new_label();
     TCGv_i32 t0 = tcg_temp_new_i32();
 
-    if (ctx->loop_mode) {
+    if (ctx->loop_mode && !ctx->loop_kernel) {
         TCGLabel *l1 = gen_new_label();
         TCGv_i32 t0 = tcg_temp_local_new_i32();
 
         tcg_gen_brcondi_i32(TCG_COND_NE, e2k_cs.lsr_pcnt, 0, l0);
-        e2k_gen_is_loop_end_i32(t0);
+        e2k_gen_is_loop_end_i32(ctx, t0);
         tcg_gen_brcondi_i32(TCG_COND_EQ, t0, 0, l1);
         tcg_gen_brcondi_i32(TCG_COND_EQ, e2k_cs.lsr_strmd, 0, l0);
         gen_set_label(l1);
@@ -2325,10 +2858,7 @@ static void gen_staa_i64(Instr *instr)
         gen_aad_ptr(ctx, t0, instr);
 
         if (instr->sm) {
-            TCGv_i32 t1 = tcg_temp_new_i32();
-            gen_helper_probe_write_access(t1, cpu_env, t0);
-            tcg_gen_brcondi_i32(TCG_COND_EQ, t1, 0, l0);
-            tcg_temp_free_i32(t1);
+            e2k_gen_sm_check(t0, true, l0);
         }
 
         tcg_gen_qemu_st_i64(s4.value, t0, ctx->mmuidx, MO_Q);
@@ -2385,10 +2915,7 @@ static void gen_staa_i32(Instr *instr, MemOp memop)
         gen_aad_ptr(ctx, t0, instr);
 
         if (instr->sm) {
-            TCGv_i32 t1 = tcg_temp_new_i32();
-            gen_helper_probe_write_access(t1, cpu_env, t0);
-            tcg_gen_brcondi_i32(TCG_COND_EQ, t1, 0, l0);
-            tcg_temp_free_i32(t1);
+            e2k_gen_sm_check(t0, true, l0);
         }
 
         tcg_gen_qemu_st_i32(s4.value, t0, ctx->mmuidx, memop);
@@ -2426,6 +2953,97 @@ static void gen_alopf1_ddd(Instr *instr,
     gen_al_result_i64(instr, dst, tag);
 }
 
+/*
+ * Quad ops run on a host vector if the host can emit it, otherwise the
+ * packed 64-bit op is applied to both halves.
+ */
+static void gen_alopf1_qqq(Instr *instr, TCGOpcode opc, unsigned vece,
+    void (*vop)(unsigned, TCGv_vec, TCGv_vec, TCGv_vec),
+    void (*op)(TCGv_i64, TCGv_i64, TCGv_i64))
+{
+    bool vec = TCG_TARGET_HAS_v128 &&
+        tcg_can_emit_vec_op(opc, TCG_TYPE_V128, vece);
+    Src128 s1 = get_src1_i128(instr, vec);
+    Src128 s2 = get_src2_i128(instr, vec);
+    TCGv_i32 tag = get_temp_i32(instr);
+
+    gen_tag2_i64(tag, s1.tag, s2.tag);
+    if (vec) {
+        TCGv_vec dst = tcg_temp_new_vec(TCG_TYPE_V128);
+
+        (*vop)(vece, dst, s1.value, s2.value);
+        gen_al_result_i128(instr, dst, NULL, NULL, tag);
+        tcg_temp_free_vec(dst);
+    } else {
+        TCGv_i64 lo = get_temp_i64(instr);
+        TCGv_i64 hi = get_temp_i64(instr);
+
+        (*op)(lo, s1.lo, s2.lo);
+        (*op)(hi, s1.hi, s2.hi);
+        gen_al_result_i128(instr, NULL, lo, hi, tag);
+    }
+
+    temp_free_src128(&s2);
+    temp_free_src128(&s1);
+}
+
+static void gen_cmpeq_vec(unsigned vece, TCGv_vec ret, TCGv_vec a, TCGv_vec b)
+{
+    tcg_gen_cmp_vec(TCG_COND_EQ, vece, ret, a, b);
+}
+
+static void gen_cmpgt_vec(unsigned vece, TCGv_vec ret, TCGv_vec a, TCGv_vec b)
+{
+    tcg_gen_cmp_vec(TCG_COND_GT, vece, ret, a, b);
+}
+
+#define IMPL_GEN_QPACKED(NAME, OPC, VECE, VOP, OP) \
+    static void NAME(Instr *instr) \
+    { \
+        gen_alopf1_qqq(instr, INDEX_op_##OPC##_vec, VECE, VOP, OP); \
+    }
+
+IMPL_GEN_QPACKED(gen_qpand, and, MO_64, tcg_gen_and_vec, tcg_gen_and_i64)
+IMPL_GEN_QPACKED(gen_qpandn, and, MO_64, tcg_gen_andc_vec, gen_andn_i64)
+IMPL_GEN_QPACKED(gen_qpor, or, MO_64, tcg_gen_or_vec, tcg_gen_or_i64)
+IMPL_GEN_QPACKED(gen_qpxor, xor, MO_64, tcg_gen_xor_vec, tcg_gen_xor_i64)
+IMPL_GEN_QPACKED(gen_qpaddb, add, MO_8, tcg_gen_add_vec, tcg_gen_vec_add8_i64)
+IMPL_GEN_QPACKED(gen_qpaddh, add, MO_16, tcg_gen_add_vec, tcg_gen_vec_add16_i64)
+IMPL_GEN_QPACKED(gen_qpaddw, add, MO_32, tcg_gen_add_vec, tcg_gen_vec_add32_i64)
+IMPL_GEN_QPACKED(gen_qpaddd, add, MO_64, tcg_gen_add_vec, tcg_gen_add_i64)
+IMPL_GEN_QPACKED(gen_qpsubb, sub, MO_8, tcg_gen_sub_vec, tcg_gen_vec_sub8_i64)
+IMPL_GEN_QPACKED(gen_qpsubh, sub, MO_16, tcg_gen_sub_vec, tcg_gen_vec_sub16_i64)
+IMPL_GEN_QPACKED(gen_qpsubw, sub, MO_32, tcg_gen_sub_vec, tcg_gen_vec_sub32_i64)
+IMPL_GEN_QPACKED(gen_qpsubd, sub, MO_64, tcg_gen_sub_vec, tcg_gen_sub_i64)
+IMPL_GEN_QPACKED(gen_qpaddsb, ssadd, MO_8, tcg_gen_ssadd_vec, gen_paddsb)
+IMPL_GEN_QPACKED(gen_qpaddsh, ssadd, MO_16, tcg_gen_ssadd_vec, gen_paddsh)
+IMPL_GEN_QPACKED(gen_qpaddusb, usadd, MO_8, tcg_gen_usadd_vec, gen_paddusb)
+IMPL_GEN_QPACKED(gen_qpaddush, usadd, MO_16, tcg_gen_usadd_vec, gen_paddush)
+IMPL_GEN_QPACKED(gen_qpsubsb, sssub, MO_8, tcg_gen_sssub_vec, gen_psubsb)
+IMPL_GEN_QPACKED(gen_qpsubsh, sssub, MO_16, tcg_gen_sssub_vec, gen_psubsh)
+IMPL_GEN_QPACKED(gen_qpsubusb, ussub, MO_8, tcg_gen_ussub_vec, gen_psubusb)
+IMPL_GEN_QPACKED(gen_qpsubush, ussub, MO_16, tcg_gen_ussub_vec, gen_psubush)
+IMPL_GEN_QPACKED(gen_qpminub, umin, MO_8, tcg_gen_umin_vec, gen_pminub)
+IMPL_GEN_QPACKED(gen_qpminsb, smin, MO_8, tcg_gen_smin_vec, gen_pminsb)
+IMPL_GEN_QPACKED(gen_qpminuh, umin, MO_16, tcg_gen_umin_vec, gen_pminuh)
+IMPL_GEN_QPACKED(gen_qpminsh, smin, MO_16, tcg_gen_smin_vec, gen_pminsh)
+IMPL_GEN_QPACKED(gen_qpminuw, umin, MO_32, tcg_gen_umin_vec, gen_pminuw)
+IMPL_GEN_QPACKED(gen_qpminsw, smin, MO_32, tcg_gen_smin_vec, gen_pminsw)
+IMPL_GEN_QPACKED(gen_qpmaxub, umax, MO_8, tcg_gen_umax_vec, gen_pmaxub)
+IMPL_GEN_QPACKED(gen_qpmaxsb, smax, MO_8, tcg_gen_smax_vec, gen_pmaxsb)
+IMPL_GEN_QPACKED(gen_qpmaxuh, umax, MO_16, tcg_gen_umax_vec, gen_pmaxuh)
+IMPL_GEN_QPACKED(gen_qpmaxsh, smax, MO_16, tcg_gen_smax_vec, gen_pmaxsh)
+IMPL_GEN_QPACKED(gen_qpmaxuw, umax, MO_32, tcg_gen_umax_vec, gen_pmaxuw)
+IMPL_GEN_QPACKED(gen_qpmaxsw, smax, MO_32, tcg_gen_smax_vec, gen_pmaxsw)
+IMPL_GEN_QPACKED(gen_qpcmpeqb, cmp, MO_8, gen_cmpeq_vec, gen_pcmpeqb)
+IMPL_GEN_QPACKED(gen_qpcmpeqh, cmp, MO_16, gen_cmpeq_vec, gen_pcmpeqh)
+IMPL_GEN_QPACKED(gen_qpcmpeqw, cmp, MO_32, gen_cmpeq_vec, gen_pcmpeqw)
+IMPL_GEN_QPACKED(gen_qpcmpeqd, cmp, MO_64, gen_cmpeq_vec, gen_pcmpeqd)
+IMPL_GEN_QPACKED(gen_qpcmpgtb, cmp, MO_8, gen_cmpgt_vec, gen_pcmpgtb)
+IMPL_GEN_QPACKED(gen_qpcmpgth, cmp, MO_16, gen_cmpgt_vec, gen_pcmpgth)
+IMPL_GEN_QPACKED(gen_qpcmpgtw, cmp, MO_32, gen_cmpgt_vec, gen_pcmpgtw)
+IMPL_GEN_QPACKED(gen_qpcmpgtd, cmp, MO_64, gen_cmpgt_vec, gen_pcmpgtd)
+
 static void gen_alopf11_dddi(Instr *instr,
     void (*op)(TCGv_i64, TCGv_i64, TCGv_i64, int))
 {
@@ -2505,25 +3123,13 @@ static void gen_alopf1_sedd(Instr *instr,
 }
 
 static inline void gen_alopf1_sf80(TCGv_i32 dst, Src80 src1, Src80 src2,
-   void (*op)(TCGv_i32, TCGv_env, TCGv_ptr, TCGv_ptr))
+   void (*op)(TCGv_i32, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-    TCGv_ptr t1 = tcg_temp_new_ptr();
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    tcg_gen_addi_ptr(t1, cpu_env, offsetof(CPUE2KState, t1.f80));
-
-    gen_temp_reg_write_i64_i32(src1.lo, src1.hi, t0);
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t1);
-
-    (*op)(dst, cpu_env, t0, t1);
-
-    tcg_temp_free_ptr(t1);
-    tcg_temp_free_ptr(t0);
+    (*op)(dst, cpu_env, src1.lo, src1.hi, src2.lo, src2.hi);
 }
 
 static void gen_alopf1_sexs(Instr *instr,
-    void (*op)(TCGv_i32, TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i32, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 s1 = get_src1_i80(instr);
     Src32 s2 = get_src2_i32(instr);
@@ -2540,7 +3146,7 @@ static void gen_alopf1_sexs(Instr *instr,
 }
 
 static void gen_alopf1_sexd(Instr *instr,
-    void (*op)(TCGv_i32, TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i32, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 s1 = get_src1_i80(instr);
     Src64 s2 = get_src2_i64(instr);
@@ -2557,7 +3163,7 @@ static void gen_alopf1_sexd(Instr *instr,
 }
 
 static void gen_alopf1_sexx(Instr *instr,
-    void (*op)(TCGv_i32, TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i32, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 s1 = get_src1_i80(instr);
     Src80 s2 = get_src2_i80(instr);
@@ -2856,42 +3462,23 @@ static void gen_alopf2_des(Instr *instr,
 }
 
 static inline void gen_alopf1_f80(Src80 *ret, Src80 src1, Src80 src2,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-    TCGv_ptr t1 = tcg_temp_new_ptr();
-
     gen_tag2_i64(ret->tag, src1.tag, src2.tag);
-
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    tcg_gen_addi_ptr(t1, cpu_env, offsetof(CPUE2KState, t1.f80));
-
-    gen_temp_reg_write_i64_i32(src1.lo, src1.hi, t0);
-    gen_temp_reg_write_i64_i32(src2.lo, src2.hi, t1);
-
-    (*op)(cpu_env, t0, t1);
-
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-
-    tcg_temp_free_ptr(t1);
-    tcg_temp_free_ptr(t0);
+    (*op)(ret->lo, cpu_env, src1.lo, src1.hi, src2.lo, src2.hi);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_alopf1_xexs_raw(Src80 *ret, Src80 src1, Src32 src2,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_i32))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i32))
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-
     gen_tag2_i64(ret->tag, src1.tag, src2.tag);
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, t0.f80));
-    gen_temp_reg_write_i64_i32(src1.lo, src1.hi, t0);
-    (*op)(cpu_env, t0, src2.value);
-    gen_temp_reg_read_i64_i32(t0, ret->lo, ret->hi);
-    tcg_temp_free_ptr(t0);
+    (*op)(ret->lo, cpu_env, src1.lo, src1.hi, src2.value);
+    gen_f80_ret_hi(ret->hi);
 }
 
 static inline void gen_alopf1_xxx(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src80 src2 = get_src2_i80(instr);
@@ -2901,7 +3488,7 @@ static inline void gen_alopf1_xxx(Instr *instr,
 }
 
 static inline void gen_alopf1_xxs(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src80 src2 = get_src2_i80(instr);
@@ -2918,7 +3505,7 @@ static inline void gen_alopf1_xxs(Instr *instr,
 }
 
 static inline void gen_alopf1_xexi(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_i32))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src32 src2 = get_src2_i32(instr);
@@ -2929,7 +3516,7 @@ static inline void gen_alopf1_xexi(Instr *instr,
 }
 
 static inline void gen_alopf1_xxd(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src80 src2 = get_src2_i80(instr);
@@ -2946,7 +3533,7 @@ static inline void gen_alopf1_xxd(Instr *instr,
 }
 
 static inline void gen_alopf1_xss(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src32 src2 = get_src2_i32(instr);
@@ -2966,7 +3553,7 @@ static inline void gen_alopf1_xss(Instr *instr,
 }
 
 static inline void gen_alopf1_xdd(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src64 src2 = get_src2_i64(instr);
@@ -2986,7 +3573,7 @@ static inline void gen_alopf1_xdd(Instr *instr,
 }
 
 static inline void gen_alopf1_xsx(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src32 src2 = get_src2_i32(instr);
@@ -3003,7 +3590,7 @@ static inline void gen_alopf1_xsx(Instr *instr,
 }
 
 static inline void gen_alopf1_xdx(Instr *instr,
-    void (*op)(TCGv_env, TCGv_ptr, TCGv_ptr))
+    void (*op)(TCGv_i64, TCGv_env, TCGv_i64, TCGv_i32, TCGv_i64, TCGv_i32))
 {
     Src80 src1 = get_src1_i80(instr);
     Src64 src2 = get_src2_i64(instr);
@@ -3082,62 +3669,100 @@ static inline void gen_alopf2_xx(Instr *instr,
     gen_al_result_i80(instr, res.lo, res.hi, res.tag);
 }
 
+static AlopKeyKind alop_key_kind(AlopDesc *desc)
+{
+    switch(desc->alopf) {
+    case ALOPF1:
+    case ALOPF1_MERGE:
+    case ALOPF3:
+    case ALOPF10:
+    case ALOPF11_LIT8:
+    case ALOPF12_PSHUFH:
+    case ALOPF21:
+        return ALOP_KEY_ANY;
+    case ALOPF2:
+    case ALOPF15:
+        return ALOP_KEY_OPCE1;
+    case ALOPF7:
+        return ALOP_KEY_CMP;
+    case ALOPF8:
+        return ALOP_KEY_CMP_C0;
+    case ALOPF11:
+    case ALOPF11_MERGE:
+    case ALOPF13:
+    case ALOPF17:
+        return ALOP_KEY_OPCE3;
+    case ALOPF12:
+    case ALOPF12_IBRANCHD:
+    case ALOPF12_ICALLD:
+    case ALOPF22:
+        return ALOP_KEY_OPCE1_OPCE3;
+    case ALOPF16:
+        return ALOP_KEY_OPCE2;
+    default:
+        return ALOP_KEY_UNUSED;
+    }
+}
+
+static inline uint32_t alop_key(int version, int opc2, int opc1, int chan,
+    uint16_t ext)
+{
+    return (((version * 4 + opc2) * 128 + opc1) * 8 + chan) << 16 | ext;
+}
+
+static inline uint32_t alop_hash(uint32_t key)
+{
+    return (key * 0x9e3779b1) >> (32 - ALOP_HASH_BITS);
+}
+
+static AlopHashEntry *alop_hash_find(uint32_t key)
+{
+    uint32_t i = alop_hash(key);
+
+    while (alops_hash[i].key != key && alops_hash[i].key != ALOP_KEY_EMPTY) {
+        i = (i + 1) & (ALOP_HASH_SIZE - 1);
+    }
+
+    return &alops_hash[i];
+}
+
 static AlopDesc *find_op(Instr *instr)
 {
     /* ALES2/5 may be allocated but must not be used */
     int opc2 = instr->ales_present & ALES_PRESENT ? instr->opc2 : 0;
-    int16_t index = alops_map[opc2][instr->opc1][instr->chan];
-    while (index != -1) {
-        bool is_match = false;
-        AlopDesc *desc = &alops[index];
-        switch(desc->alopf) {
-        case ALOPF1:
-        case ALOPF1_MERGE:
-        case ALOPF3:
-        case ALOPF10:
-        case ALOPF11_LIT8:
-        case ALOPF12_PSHUFH:
-        case ALOPF21:
-            is_match = true;
-            break;
-        case ALOPF2:
-        case ALOPF15:
-            is_match = desc->extra1 == instr->opce1;
-            break;
-        case ALOPF7:
-            is_match = desc->extra1 == instr->opc_cmp;
-            break;
-        case ALOPF8:
-            is_match = desc->extra1 == instr->opc_cmp && instr->opce1 == 0xc0;
-            break;
-        case ALOPF11:
-        case ALOPF11_MERGE:
-        case ALOPF13:
-        case ALOPF17:
-            is_match = desc->extra1 == instr->opce3;
-            break;
-        case ALOPF12:
-        case ALOPF12_IBRANCHD:
-        case ALOPF12_ICALLD:
-        case ALOPF22:
-            is_match = desc->extra1 == instr->opce1 && desc->extra2 == instr->opce3;
-            break;
-        case ALOPF16:
-            is_match = desc->extra1 == instr->opce2;
-            break;
-        default:
-            g_assert_not_reached();
-            break;
-        }
+    int version = instr->ctx->version;
+    uint16_t ext;
+    AlopHashEntry *e;
 
-        if (is_match) {
-            return desc;
-        }
-
-        index = desc->next[instr->chan];
+    switch (alops_kind[version][opc2][instr->opc1][instr->chan]) {
+    case ALOP_KEY_ANY:
+        ext = 0;
+        break;
+    case ALOP_KEY_OPCE1:
+        ext = instr->opce1;
+        break;
+    case ALOP_KEY_CMP:
+        ext = instr->opc_cmp;
+        break;
+    case ALOP_KEY_CMP_C0:
+        ext = instr->opce1 == 0xc0 ? instr->opc_cmp : ALOP_EXT_NONE;
+        break;
+    case ALOP_KEY_OPCE3:
+        ext = instr->opce3;
+        break;
+    case ALOP_KEY_OPCE1_OPCE3:
+        ext = instr->opce1 << 8 | instr->opce3;
+        break;
+    case ALOP_KEY_OPCE2:
+        ext = instr->opce2;
+        break;
+    default:
+        return NULL;
     }
 
-    return NULL;
+    e = alop_hash_find(alop_key(version, opc2, instr->opc1, instr->chan, ext));
+
+    return e->key != ALOP_KEY_EMPTY ? &alops[e->index] : NULL;
 }
 
 static inline void check_reg_src(DisasContext *ctx, uint8_t src)
@@ -3158,9 +3783,60 @@ static inline void check_reg_dst(DisasContext *ctx, uint8_t dst)
     }
 }
 
+/* Returns the source operands of an ALOP, immediates and literals included. */
+static int alop_srcs(Alopf alopf, Instr *instr, uint8_t *srcs)
+{
+    switch(alopf) {
+    case ALOPF1:
+    case ALOPF1_MERGE:
+    case ALOPF11:
+    case ALOPF11_MERGE:
+    case ALOPF11_LIT8:
+    case ALOPF7:
+    case ALOPF17:
+        srcs[0] = instr->src1;
+        srcs[1] = instr->src2;
+        return 2;
+    case ALOPF2:
+    case ALOPF12:
+    case ALOPF12_PSHUFH:
+    case ALOPF15:
+    case ALOPF22:
+    case ALOPF8:
+        srcs[0] = instr->src2;
+        return 1;
+    case ALOPF3:
+    case ALOPF13:
+        srcs[0] = instr->src1;
+        srcs[1] = instr->src2;
+        srcs[2] = instr->src4;
+        return 3;
+    case ALOPF10:
+        srcs[0] = instr->src4;
+        return 1;
+    case ALOPF21:
+    case ALOPF21_ICOMB:
+    case ALOPF21_FCOMB:
+    case ALOPF21_PFCOMB:
+    case ALOPF21_LCOMB:
+        srcs[0] = instr->src1;
+        srcs[1] = instr->src2;
+        srcs[2] = instr->src3;
+        return 3;
+    default:
+        return 0;
+    }
+}
+
 static void check_args(Alopf alopf, Instr *instr)
 {
     DisasContext *ctx = instr->ctx;
+    uint8_t srcs[3];
+    int i, n = alop_srcs(alopf, instr, srcs);
+
+    for (i = 0; i < n; i++) {
+        check_reg_src(ctx, srcs[i]);
+    }
 
     switch(alopf) {
     case ALOPF1:
@@ -3168,53 +3844,28 @@ static void check_args(Alopf alopf, Instr *instr)
     case ALOPF11:
     case ALOPF11_MERGE:
     case ALOPF11_LIT8:
-        check_reg_src(ctx, instr->src1);
-        check_reg_src(ctx, instr->src2);
-        check_reg_dst(ctx, instr->dst);
-        break;
     case ALOPF2:
     case ALOPF12:
     case ALOPF12_PSHUFH:
     case ALOPF15:
     case ALOPF22:
-        check_reg_src(ctx, instr->src2);
+    case ALOPF16:
+    case ALOPF21:
+    case ALOPF21_ICOMB:
+    case ALOPF21_FCOMB:
+    case ALOPF21_PFCOMB:
+    case ALOPF21_LCOMB:
         check_reg_dst(ctx, instr->dst);
         break;
     case ALOPF3:
-        check_reg_src(ctx, instr->src1);
-        check_reg_src(ctx, instr->src2);
-        check_reg_src(ctx, instr->src4);
-        break;
     case ALOPF7:
     case ALOPF17:
-        check_reg_src(ctx, instr->src1);
-        check_reg_src(ctx, instr->src2);
-        break;
     case ALOPF8:
-        check_reg_src(ctx, instr->src2);
-        break;
     case ALOPF10:
-        check_reg_src(ctx, instr->src4);
         break;
     case ALOPF13:
         // FIXME: not tested
         e2k_todo(ctx, "check_args ALOPF13");
-        check_reg_src(ctx, instr->src1);
-        check_reg_src(ctx, instr->src2);
-        check_reg_src(ctx, instr->src4);
-        break;
-    case ALOPF16:
-        check_reg_dst(ctx, instr->dst);
-        break;
-    case ALOPF21:
-    case ALOPF21_ICOMB:
-    case ALOPF21_FCOMB:
-    case ALOPF21_PFCOMB:
-    case ALOPF21_LCOMB:
-        check_reg_src(ctx, instr->src1);
-        check_reg_src(ctx, instr->src2);
-        check_reg_src(ctx, instr->src3);
-        check_reg_dst(ctx, instr->dst);
         break;
     default:
         e2k_todo(ctx, "check_args %d", alopf);
@@ -3462,34 +4113,34 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_PANDND: gen_alopf1_ddd(instr, gen_andn_i64); break;
     case OP_PORD: gen_alopf1_ddd(instr, tcg_gen_or_i64); break;
     case OP_PXORD: gen_alopf1_ddd(instr, tcg_gen_xor_i64); break;
-    case OP_PMINUB: gen_alopf1_ddd(instr, gen_helper_pminub); break;
-    case OP_PMINSB: gen_alopf1_ddd(instr, gen_helper_pminsb); break;
-    case OP_PMINUH: gen_alopf1_ddd(instr, gen_helper_pminuh); break;
-    case OP_PMINSH: gen_alopf1_ddd(instr, gen_helper_pminsh); break;
-    case OP_PMINUW: gen_alopf1_ddd(instr, gen_helper_pminuw); break;
-    case OP_PMINSW: gen_alopf1_ddd(instr, gen_helper_pminsw); break;
-    case OP_PMAXUB: gen_alopf1_ddd(instr, gen_helper_pmaxub); break;
-    case OP_PMAXSB: gen_alopf1_ddd(instr, gen_helper_pmaxsb); break;
-    case OP_PMAXUH: gen_alopf1_ddd(instr, gen_helper_pmaxuh); break;
-    case OP_PMAXSH: gen_alopf1_ddd(instr, gen_helper_pmaxsh); break;
-    case OP_PMAXUW: gen_alopf1_ddd(instr, gen_helper_pmaxuw); break;
-    case OP_PMAXSW: gen_alopf1_ddd(instr, gen_helper_pmaxsw); break;
-    case OP_PCMPEQB: gen_alopf1_ddd(instr, gen_helper_pcmpeqb); break;
-    case OP_PCMPEQH: gen_alopf1_ddd(instr, gen_helper_pcmpeqh); break;
-    case OP_PCMPEQW: gen_alopf1_ddd(instr, gen_helper_pcmpeqw); break;
-    case OP_PCMPEQD: gen_alopf1_ddd(instr, gen_helper_pcmpeqd); break;
-    case OP_PCMPGTB: gen_alopf1_ddd(instr, gen_helper_pcmpgtb); break;
-    case OP_PCMPGTH: gen_alopf1_ddd(instr, gen_helper_pcmpgth); break;
-    case OP_PCMPGTW: gen_alopf1_ddd(instr, gen_helper_pcmpgtw); break;
-    case OP_PCMPGTD: gen_alopf1_ddd(instr, gen_helper_pcmpgtd); break;
+    case OP_PMINUB: gen_alopf1_ddd(instr, gen_pminub); break;
+    case OP_PMINSB: gen_alopf1_ddd(instr, gen_pminsb); break;
+    case OP_PMINUH: gen_alopf1_ddd(instr, gen_pminuh); break;
+    case OP_PMINSH: gen_alopf1_ddd(instr, gen_pminsh); break;
+    case OP_PMINUW: gen_alopf1_ddd(instr, gen_pminuw); break;
+    case OP_PMINSW: gen_alopf1_ddd(instr, gen_pminsw); break;
+    case OP_PMAXUB: gen_alopf1_ddd(instr, gen_pmaxub); break;
+    case OP_PMAXSB: gen_alopf1_ddd(instr, gen_pmaxsb); break;
+    case OP_PMAXUH: gen_alopf1_ddd(instr, gen_pmaxuh); break;
+    case OP_PMAXSH: gen_alopf1_ddd(instr, gen_pmaxsh); break;
+    case OP_PMAXUW: gen_alopf1_ddd(instr, gen_pmaxuw); break;
+    case OP_PMAXSW: gen_alopf1_ddd(instr, gen_pmaxsw); break;
+    case OP_PCMPEQB: gen_alopf1_ddd(instr, gen_pcmpeqb); break;
+    case OP_PCMPEQH: gen_alopf1_ddd(instr, gen_pcmpeqh); break;
+    case OP_PCMPEQW: gen_alopf1_ddd(instr, gen_pcmpeqw); break;
+    case OP_PCMPEQD: gen_alopf1_ddd(instr, gen_pcmpeqd); break;
+    case OP_PCMPGTB: gen_alopf1_ddd(instr, gen_pcmpgtb); break;
+    case OP_PCMPGTH: gen_alopf1_ddd(instr, gen_pcmpgth); break;
+    case OP_PCMPGTW: gen_alopf1_ddd(instr, gen_pcmpgtw); break;
+    case OP_PCMPGTD: gen_alopf1_ddd(instr, gen_pcmpgtd); break;
     case OP_PADDB: gen_alopf1_ddd(instr, tcg_gen_vec_add8_i64); break;
     case OP_PADDH: gen_alopf1_ddd(instr, tcg_gen_vec_add16_i64); break;
     case OP_PADDW: gen_alopf1_ddd(instr, tcg_gen_vec_add32_i64); break;
     case OP_PADDD: gen_alopf1_ddd(instr, tcg_gen_add_i64); break;
-    case OP_PADDSB: gen_alopf1_ddd(instr, gen_helper_paddsb); break;
-    case OP_PADDSH: gen_alopf1_ddd(instr, gen_helper_paddsh); break;
-    case OP_PADDUSB: gen_alopf1_ddd(instr, gen_helper_paddusb); break;
-    case OP_PADDUSH: gen_alopf1_ddd(instr, gen_helper_paddush); break;
+    case OP_PADDSB: gen_alopf1_ddd(instr, gen_paddsb); break;
+    case OP_PADDSH: gen_alopf1_ddd(instr, gen_paddsh); break;
+    case OP_PADDUSB: gen_alopf1_ddd(instr, gen_paddusb); break;
+    case OP_PADDUSH: gen_alopf1_ddd(instr, gen_paddush); break;
     case OP_PHADDH: gen_alopf1_ddd(instr, gen_helper_phaddh); break;
     case OP_PHADDW: gen_alopf1_ddd(instr, gen_helper_phaddw); break;
     case OP_PHADDSH:  gen_alopf1_ddd(instr, gen_helper_phaddsh); break;
@@ -3497,10 +4148,10 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_PSUBH: gen_alopf1_ddd(instr, tcg_gen_vec_sub16_i64); break;
     case OP_PSUBW: gen_alopf1_ddd(instr, tcg_gen_vec_sub32_i64); break;
     case OP_PSUBD: gen_alopf1_ddd(instr, tcg_gen_sub_i64); break;
-    case OP_PSUBSB: gen_alopf1_ddd(instr, gen_helper_psubsb); break;
-    case OP_PSUBSH: gen_alopf1_ddd(instr, gen_helper_psubsh); break;
-    case OP_PSUBUSB: gen_alopf1_ddd(instr, gen_helper_psubusb); break;
-    case OP_PSUBUSH: gen_alopf1_ddd(instr, gen_helper_psubush); break;
+    case OP_PSUBSB: gen_alopf1_ddd(instr, gen_psubsb); break;
+    case OP_PSUBSH: gen_alopf1_ddd(instr, gen_psubsh); break;
+    case OP_PSUBUSB: gen_alopf1_ddd(instr, gen_psubusb); break;
+    case OP_PSUBUSH: gen_alopf1_ddd(instr, gen_psubush); break;
     case OP_PHSUBH: gen_alopf1_ddd(instr, gen_helper_phsubh); break;
     case OP_PHSUBW: gen_alopf1_ddd(instr, gen_helper_phsubw); break;
     case OP_PHSUBSH: gen_alopf1_ddd(instr, gen_helper_phsubsh); break;
@@ -3516,16 +4167,16 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_PSIGNB: gen_alopf1_ddd(instr, gen_helper_psignb); break;
     case OP_PSIGNH: gen_alopf1_ddd(instr, gen_helper_psignh); break;
     case OP_PSIGNW: gen_alopf1_ddd(instr, gen_helper_psignw); break;
-    case OP_PSLLH: gen_alopf1_ddd(instr, gen_helper_psllh); break;
-    case OP_PSLLW: gen_alopf1_ddd(instr, gen_helper_psllw); break;
+    case OP_PSLLH: gen_alopf1_ddd(instr, gen_psllh); break;
+    case OP_PSLLW: gen_alopf1_ddd(instr, gen_psllw); break;
     case OP_PSLLD: gen_alopf1_ddd(instr, tcg_gen_shl_i64); break;
-    case OP_PSRLH: gen_alopf1_ddd(instr, gen_helper_psrlh); break;
-    case OP_PSRLW: gen_alopf1_ddd(instr, gen_helper_psrlw); break;
+    case OP_PSRLH: gen_alopf1_ddd(instr, gen_psrlh); break;
+    case OP_PSRLW: gen_alopf1_ddd(instr, gen_psrlw); break;
     case OP_PSRLD: gen_alopf1_ddd(instr, tcg_gen_shr_i64); break;
-    case OP_PSRAH: gen_alopf1_ddd(instr, gen_helper_psrah); break;
-    case OP_PSRAW: gen_alopf1_ddd(instr, gen_helper_psraw); break;
-    case OP_PAVGUSB: gen_alopf1_ddd(instr, gen_helper_pavgusb); break;
-    case OP_PAVGUSH: gen_alopf1_ddd(instr, gen_helper_pavgush); break;
+    case OP_PSRAH: gen_alopf1_ddd(instr, gen_psrah); break;
+    case OP_PSRAW: gen_alopf1_ddd(instr, gen_psraw); break;
+    case OP_PAVGUSB: gen_alopf1_ddd(instr, gen_pavgusb); break;
+    case OP_PAVGUSH: gen_alopf1_ddd(instr, gen_pavgush); break;
     case OP_PSLLQL: gen_alopf11_dddi(instr, gen_psllql); break;
     case OP_PSLLQH: gen_alopf11_dddi(instr, gen_psllqh); break;
     case OP_PSRLQL: gen_alopf11_dddi(instr, gen_psrlql); break;
@@ -3541,13 +4192,53 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_PACKUSHB: gen_alopf1_ddd(instr, gen_helper_packushb); break;
     case OP_PACKSSWH: gen_alopf1_ddd(instr, gen_helper_packsswh); break;
     case OP_PACKUSWH: gen_alopf1_ddd(instr, gen_helper_packuswh); break;
-    case OP_PUNPCKLBH: gen_alopf1_ddd(instr, gen_helper_punpcklbh); break;
-    case OP_PUNPCKLHW: gen_alopf1_ddd(instr, gen_helper_punpcklhw); break;
-    case OP_PUNPCKLWD: gen_alopf1_ddd(instr, gen_helper_punpcklwd); break;
-    case OP_PUNPCKHBH: gen_alopf1_ddd(instr, gen_helper_punpckhbh); break;
-    case OP_PUNPCKHHW: gen_alopf1_ddd(instr, gen_helper_punpckhhw); break;
-    case OP_PUNPCKHWD: gen_alopf1_ddd(instr, gen_helper_punpckhwd); break;
+    case OP_PUNPCKLBH: gen_alopf1_ddd(instr, gen_punpcklbh); break;
+    case OP_PUNPCKLHW: gen_alopf1_ddd(instr, gen_punpcklhw); break;
+    case OP_PUNPCKLWD: gen_alopf1_ddd(instr, gen_punpcklwd); break;
+    case OP_PUNPCKHBH: gen_alopf1_ddd(instr, gen_punpckhbh); break;
+    case OP_PUNPCKHHW: gen_alopf1_ddd(instr, gen_punpckhhw); break;
+    case OP_PUNPCKHWD: gen_alopf1_ddd(instr, gen_punpckhwd); break;
     case OP_PHMINPOSUH: gen_alopf1_ddd(instr, gen_helper_phminposuh); break;
+    case OP_QPAND: gen_qpand(instr); break;
+    case OP_QPANDN: gen_qpandn(instr); break;
+    case OP_QPOR: gen_qpor(instr); break;
+    case OP_QPXOR: gen_qpxor(instr); break;
+    case OP_QPADDB: gen_qpaddb(instr); break;
+    case OP_QPADDH: gen_qpaddh(instr); break;
+    case OP_QPADDW: gen_qpaddw(instr); break;
+    case OP_QPADDD: gen_qpaddd(instr); break;
+    case OP_QPSUBB: gen_qpsubb(instr); break;
+    case OP_QPSUBH: gen_qpsubh(instr); break;
+    case OP_QPSUBW: gen_qpsubw(instr); break;
+    case OP_QPSUBD: gen_qpsubd(instr); break;
+    case OP_QPADDSB: gen_qpaddsb(instr); break;
+    case OP_QPADDSH: gen_qpaddsh(instr); break;
+    case OP_QPADDUSB: gen_qpaddusb(instr); break;
+    case OP_QPADDUSH: gen_qpaddush(instr); break;
+    case OP_QPSUBSB: gen_qpsubsb(instr); break;
+    case OP_QPSUBSH: gen_qpsubsh(instr); break;
+    case OP_QPSUBUSB: gen_qpsubusb(instr); break;
+    case OP_QPSUBUSH: gen_qpsubush(instr); break;
+    case OP_QPMINUB: gen_qpminub(instr); break;
+    case OP_QPMINSB: gen_qpminsb(instr); break;
+    case OP_QPMINUH: gen_qpminuh(instr); break;
+    case OP_QPMINSH: gen_qpminsh(instr); break;
+    case OP_QPMINUW: gen_qpminuw(instr); break;
+    case OP_QPMINSW: gen_qpminsw(instr); break;
+    case OP_QPMAXUB: gen_qpmaxub(instr); break;
+    case OP_QPMAXSB: gen_qpmaxsb(instr); break;
+    case OP_QPMAXUH: gen_qpmaxuh(instr); break;
+    case OP_QPMAXSH: gen_qpmaxsh(instr); break;
+    case OP_QPMAXUW: gen_qpmaxuw(instr); break;
+    case OP_QPMAXSW: gen_qpmaxsw(instr); break;
+    case OP_QPCMPEQB: gen_qpcmpeqb(instr); break;
+    case OP_QPCMPEQH: gen_qpcmpeqh(instr); break;
+    case OP_QPCMPEQW: gen_qpcmpeqw(instr); break;
+    case OP_QPCMPEQD: gen_qpcmpeqd(instr); break;
+    case OP_QPCMPGTB: gen_qpcmpgtb(instr); break;
+    case OP_QPCMPGTH: gen_qpcmpgth(instr); break;
+    case OP_QPCMPGTW: gen_qpcmpgtw(instr); break;
+    case OP_QPCMPGTD: gen_qpcmpgtd(instr); break;
     case OP_GETTAGS: gen_gettag_i32(instr); break;
     case OP_GETTAGD: gen_gettag_i64(instr); break;
     case OP_PUTTAGS: gen_puttag_i32(instr); break;
@@ -3827,26 +4518,6 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_MOVTRCQ:
     case OP_PUTTST:
     case OP_STAAQP:
-    case OP_QPAND:
-    case OP_QPANDN:
-    case OP_QPOR:
-    case OP_QPXOR:
-    case OP_QPADDB:
-    case OP_QPADDH:
-    case OP_QPADDSB:
-    case OP_QPADDSH:
-    case OP_QPADDUSB:
-    case OP_QPADDUSH:
-    case OP_QPADDW:
-    case OP_QPADDD:
-    case OP_QPSUBB:
-    case OP_QPSUBH:
-    case OP_QPSUBSB:
-    case OP_QPSUBSH:
-    case OP_QPSUBUSB:
-    case OP_QPSUBUSH:
-    case OP_QPSUBW:
-    case OP_QPSUBD:
     case OP_QPFADDS:
     case OP_QPFADDD:
     case OP_QPFHADDS:
@@ -3879,32 +4550,12 @@ static void gen_alop_simple(Instr *instr, uint32_t op, const char *name)
     case OP_QPACKUSWH:
     case OP_QPAVGUSB:
     case OP_QPAVGUSH:
-    case OP_QPCMPEQB:
-    case OP_QPCMPEQD:
-    case OP_QPCMPEQH:
-    case OP_QPCMPEQW:
-    case OP_QPCMPGTB:
-    case OP_QPCMPGTD:
-    case OP_QPCMPGTH:
-    case OP_QPCMPGTW:
     case OP_QPHADDH:
     case OP_QPHADDSH:
     case OP_QPHADDW:
     case OP_QPHSUBH:
     case OP_QPHSUBSH:
     case OP_QPHSUBW:
-    case OP_QPMAXSB:
-    case OP_QPMAXSH:
-    case OP_QPMAXSW:
-    case OP_QPMAXUB:
-    case OP_QPMAXUH:
-    case OP_QPMAXUW:
-    case OP_QPMINSB:
-    case OP_QPMINSH:
-    case OP_QPMINSW:
-    case OP_QPMINUB:
-    case OP_QPMINUH:
-    case OP_QPMINUW:
     case OP_QPMULHH:
     case OP_QPMULHRSH:
     case OP_QPMULHUH:
@@ -4177,62 +4828,75 @@ static inline bool fcomb_check(Instr *instr, FComb opc1, FComb opc2)
     }
 }
 
-static bool pfcomb_map[FCOMB_COUNT][FCOMB_COUNT] = { false };
+static bool pfcomb_map[ALOP_VERSION_COUNT][FCOMB_COUNT][FCOMB_COUNT];
 
-static void pfcomb_init(DisasContext *ctx)
+static void pfcomb_init_version(int version)
 {
-    pfcomb_map[FCOMB_MUL][FCOMB_ADD] = true;
-    pfcomb_map[FCOMB_MUL][FCOMB_SUB] = true;
-    pfcomb_map[FCOMB_MUL][FCOMB_RSUB] = true;
-
-    if (ctx->version == 1) {
-        pfcomb_map[FCOMB_ADD][FCOMB_MUL] = true;
-        pfcomb_map[FCOMB_SUB][FCOMB_MUL] = true;
-    }
+    bool (*pfcomb)[FCOMB_COUNT] = pfcomb_map[version];
 
-    if (ctx->version >= 2) {
-        pfcomb_map[FCOMB_ADD][FCOMB_ADD] = true;
-        pfcomb_map[FCOMB_ADD][FCOMB_SUB] = true;
-        pfcomb_map[FCOMB_ADD][FCOMB_RSUB] = true;
+    pfcomb[FCOMB_MUL][FCOMB_ADD] = true;
+    pfcomb[FCOMB_MUL][FCOMB_SUB] = true;
+    pfcomb[FCOMB_MUL][FCOMB_RSUB] = true;
 
-        pfcomb_map[FCOMB_SUB][FCOMB_ADD] = true;
-        pfcomb_map[FCOMB_SUB][FCOMB_SUB] = true;
-        pfcomb_map[FCOMB_SUB][FCOMB_RSUB] = true;
+    if (version == 1) {
+        pfcomb[FCOMB_ADD][FCOMB_MUL] = true;
+        pfcomb[FCOMB_SUB][FCOMB_MUL] = true;
     }
 
-    if (ctx->version >= 3) {
-        pfcomb_map[FCOMB_HADD][FCOMB_ADD] = true;
-        pfcomb_map[FCOMB_HADD][FCOMB_SUB] = true;
-        pfcomb_map[FCOMB_HADD][FCOMB_RSUB] = true;
-        pfcomb_map[FCOMB_HADD][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_HADD][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_HADD][FCOMB_ADDSUB] = true;
+    if (version >= 2) {
+        pfcomb[FCOMB_ADD][FCOMB_ADD] = true;
+        pfcomb[FCOMB_ADD][FCOMB_SUB] = true;
+        pfcomb[FCOMB_ADD][FCOMB_RSUB] = true;
 
-        pfcomb_map[FCOMB_HSUB][FCOMB_ADD] = true;
-        pfcomb_map[FCOMB_HSUB][FCOMB_SUB] = true;
-        pfcomb_map[FCOMB_HSUB][FCOMB_RSUB] = true;
-        pfcomb_map[FCOMB_HSUB][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_HSUB][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_HSUB][FCOMB_ADDSUB] = true;
+        pfcomb[FCOMB_SUB][FCOMB_ADD] = true;
+        pfcomb[FCOMB_SUB][FCOMB_SUB] = true;
+        pfcomb[FCOMB_SUB][FCOMB_RSUB] = true;
+    }
 
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_ADD] = true;
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_SUB] = true;
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_RSUB] = true;
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_ADDSUB][FCOMB_ADDSUB] = true;
+    if (version >= 3) {
+        pfcomb[FCOMB_HADD][FCOMB_ADD] = true;
+        pfcomb[FCOMB_HADD][FCOMB_SUB] = true;
+        pfcomb[FCOMB_HADD][FCOMB_RSUB] = true;
+        pfcomb[FCOMB_HADD][FCOMB_HADD] = true;
+        pfcomb[FCOMB_HADD][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_HADD][FCOMB_ADDSUB] = true;
+
+        pfcomb[FCOMB_HSUB][FCOMB_ADD] = true;
+        pfcomb[FCOMB_HSUB][FCOMB_SUB] = true;
+        pfcomb[FCOMB_HSUB][FCOMB_RSUB] = true;
+        pfcomb[FCOMB_HSUB][FCOMB_HADD] = true;
+        pfcomb[FCOMB_HSUB][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_HSUB][FCOMB_ADDSUB] = true;
+
+        pfcomb[FCOMB_ADDSUB][FCOMB_ADD] = true;
+        pfcomb[FCOMB_ADDSUB][FCOMB_SUB] = true;
+        pfcomb[FCOMB_ADDSUB][FCOMB_RSUB] = true;
+        pfcomb[FCOMB_ADDSUB][FCOMB_HADD] = true;
+        pfcomb[FCOMB_ADDSUB][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_ADDSUB][FCOMB_ADDSUB] = true;
+
+        pfcomb[FCOMB_ADD][FCOMB_HADD] = true;
+        pfcomb[FCOMB_ADD][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_ADD][FCOMB_ADDSUB] = true;
+
+        pfcomb[FCOMB_SUB][FCOMB_HADD] = true;
+        pfcomb[FCOMB_SUB][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_SUB][FCOMB_ADDSUB] = true;
+
+        pfcomb[FCOMB_MUL][FCOMB_HADD] = true;
+        pfcomb[FCOMB_MUL][FCOMB_HSUB] = true;
+        pfcomb[FCOMB_MUL][FCOMB_ADDSUB] = true;
+    }
+}
 
-        pfcomb_map[FCOMB_ADD][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_ADD][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_ADD][FCOMB_ADDSUB] = true;
+static void pfcomb_init(void)
+{
+    int i;
 
-        pfcomb_map[FCOMB_SUB][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_SUB][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_SUB][FCOMB_ADDSUB] = true;
+    memset(pfcomb_map, 0, sizeof(pfcomb_map));
 
-        pfcomb_map[FCOMB_MUL][FCOMB_HADD] = true;
-        pfcomb_map[FCOMB_MUL][FCOMB_HSUB] = true;
-        pfcomb_map[FCOMB_MUL][FCOMB_ADDSUB] = true;
+    for (i = 1; i < ALOP_VERSION_COUNT; i++) {
+        pfcomb_init_version(i);
     }
 }
 
@@ -4244,7 +4908,7 @@ static inline bool pfcomb_check(Instr *instr, FComb opc1, FComb opc2)
         return false;
     }
 
-    return pfcomb_map[opc1][opc2];
+    return pfcomb_map[ver][opc1][opc2];
 }
 
 #define IMPL_GEN_FCOMB_OP(S, T) \
@@ -4344,6 +5008,49 @@ IMPL_GEN_COMB_SELECT(icomb)
 IMPL_GEN_COMB_SELECT(fcomb)
 IMPL_GEN_COMB_SELECT(pfcomb)
 
+/*
+ * Evaluates a truth table of n inputs on whole words. Bit i of the table is
+ * the result for the inputs that are the bits of i, src[0] being the most
+ * significant one. The table is split on src[0] and both halves are
+ * evaluated on the remaining inputs, constant and equal halves fold away.
+ */
+static void gen_truth_table_i64(TCGv_i64 ret, uint32_t table, TCGv_i64 *src,
+    int n)
+{
+    uint32_t mask = (1u << (1 << n)) - 1;
+    uint32_t lo, hi;
+    TCGv_i64 t0, t1;
+    int half;
+
+    table &= mask;
+    if (table == 0 || table == mask) {
+        tcg_gen_movi_i64(ret, table ? -1 : 0);
+        return;
+    }
+
+    /* a table of no inputs is constant, so n >= 1 here */
+    half = 1 << (n - 1);
+    lo = table & ((1u << half) - 1);
+    hi = table >> half;
+    if (lo == hi) {
+        gen_truth_table_i64(ret, lo, src + 1, n - 1);
+        return;
+    }
+
+    t0 = tcg_temp_new_i64();
+    t1 = tcg_temp_new_i64();
+
+    gen_truth_table_i64(t0, lo, src + 1, n - 1);
+    gen_truth_table_i64(t1, hi, src + 1, n - 1);
+    /* ret = src[0] ? t1 : t0 */
+    tcg_gen_xor_i64(t1, t1, t0);
+    tcg_gen_and_i64(t1, t1, src[0]);
+    tcg_gen_xor_i64(ret, t0, t1);
+
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t0);
+}
+
 static void gen_lcomb_i64(Instr *instr, uint32_t base)
 {
     /* see gen_alopf21_i64 */
@@ -4352,11 +5059,11 @@ static void gen_lcomb_i64(Instr *instr, uint32_t base)
     Src64 s3 = get_src3_i64(instr);
     TCGv_i32 tag = get_temp_i32(instr);
     TCGv_i64 dst = get_temp_i64(instr);
-    TCGv_i32 opc = tcg_const_i32(base + instr->opc1);
+    TCGv_i64 src[3] = { s1.value, s2.value, s3.value };
 
     check_args(ALOPF21, instr);
     gen_tag3_i64(tag, s1.tag, s2.tag, s3.tag);
-    gen_helper_plog(dst, opc, s1.value, s2.value, s3.value);
+    gen_truth_table_i64(dst, base + instr->opc1, src, 3);
     gen_al_result_i64(instr, dst, tag);
 }
 
@@ -4404,7 +5111,7 @@ static void chan_check_preds(DisasContext *ctx, int chan, TCGLabel *l)
             switch(kind) {
             case 0x2: { /* %pcntN */
                 has_pcnt = true;
-                tcg_gen_setcondi_i32(TCG_COND_LEU, t2, e2k_cs.lsr_pcnt, idx);
+                e2k_gen_pcnt_i32(ctx, t2, idx);
                 if (invert) {
                     tcg_gen_xori_i32(t2, t2, 1);
                 }
@@ -4413,7 +5120,7 @@ static void chan_check_preds(DisasContext *ctx, int chan, TCGLabel *l)
             }
             case 0x3: /* %predN */
                 has_preg = true;
-                e2k_gen_preg_i32(t2, idx);
+                e2k_gen_preg_i32(ctx, t2, idx);
                 if (invert) {
                     tcg_gen_xori_i32(t2, t2, 1);
                 }
@@ -4584,6 +5291,19 @@ void e2k_alc_decode(DisasContext *ctx)
     }
 }
 
+static inline bool alop_is_dam_check(Instr *instr, Alop *alop)
+{
+    switch (alop->op) {
+    case OP_LDB:
+    case OP_LDH:
+    case OP_LDW:
+    case OP_LDD:
+        return is_dam_check(instr);
+    default:
+        return false;
+    }
+}
+
 static void gen_alop(Instr *instr, Alop *alop)
 {
     TCGLabel *l0 = gen_new_label();
@@ -4592,6 +5312,12 @@ static void gen_alop(Instr *instr, Alop *alop)
         return;
     }
 
+    if (alop_is_dam_check(instr, alop) && instr->ctx->mlock == NULL) {
+        /* must be set even if the check load is not executed */
+        instr->ctx->mlock = e2k_get_temp_i32(instr->ctx);
+        tcg_gen_movi_i32(instr->ctx->mlock, 0);
+    }
+
     chan_check_preds(instr->ctx, instr->chan, l0);
     check_args(alop->format, instr);
 
@@ -4634,44 +5360,126 @@ static void gen_alops(DisasContext *ctx)
     }
 }
 
+/*
+ * ORs the tags of all register sources of the bundle into ret and marks
+ * them as checked, see gen_src_tag.
+ */
+void e2k_alc_gen_src_tags(DisasContext *ctx, TCGv_i32 ret)
+{
+    TCGv_i32 t0 = tcg_temp_new_i32();
+    int i, j;
+
+    tcg_gen_movi_i32(ret, 0);
+    for (i = 0; i < 6; i++) {
+        Alop *alop = &ctx->bundle2.alops[i];
+        uint8_t srcs[3];
+        Instr instr;
+        int n;
+
+        if (alop->format == ALOPF_NONE) {
+            continue;
+        }
+
+        alop_instr_init(&instr, ctx, i);
+        n = alop_srcs(alop->format, &instr, srcs);
+        for (j = 0; j < n; j++) {
+            uint8_t arg = srcs[j];
+            Reg r;
+
+            if ((!IS_REGULAR(arg) && !IS_BASED(arg) && !IS_GLOBAL(arg)) ||
+                test_bit(arg, ctx->src_checked))
+            {
+                continue;
+            }
+
+            set_bit(arg, ctx->src_checked);
+            r.off = tcg_temp_new_i32();
+            e2k_gen_reg_index(ctx, &r, arg);
+            e2k_gen_reg_tag_read_i64(ctx, t0, &r);
+            tcg_gen_or_i32(ret, ret, t0);
+            tcg_temp_free_i32(r.off);
+        }
+    }
+
+    tcg_temp_free_i32(t0);
+}
+
 void e2k_alc_execute(DisasContext *ctx)
 {
     gen_alops(ctx);
 }
 
-static inline void gen_al_result_commit_reg32(bool poison, TCGv_i32 index,
+static inline void gen_al_result_commit_reg32(DisasContext *ctx,
+    bool poison, Reg *index,
     TCGv_i32 tag, TCGv_i32 value)
 {
     TCGv_i32 t0 = tcg_temp_new_i32();
 
-    e2k_gen_reg_tag_write_i32(tag, index);
+    e2k_gen_reg_tag_write_i32(ctx, tag, index);
     if (poison) {
         gen_dst_poison_i32(t0, value, tag);
     } else {
         tcg_gen_mov_i32(t0, value);
     }
-    e2k_gen_reg_write_i32(t0, index);
+    e2k_gen_reg_write_i32(ctx, t0, index);
 
     tcg_temp_free_i32(t0);
 }
 
-static inline void gen_al_result_commit_reg64(bool poison, TCGv_i32 index,
+static inline void gen_al_result_commit_reg64(DisasContext *ctx,
+    bool poison, Reg *index,
     TCGv_i32 tag, TCGv_i64 value)
 {
     TCGv_i64 t0 = tcg_temp_new_i64();
 
-    e2k_gen_reg_tag_write_i64(tag, index);
+    e2k_gen_reg_tag_write_i64(ctx, tag, index);
     if (poison) {
         gen_dst_poison_i64(t0, value, tag);
     } else {
         tcg_gen_mov_i64(t0, value);
     }
-    e2k_gen_reg_write_i64(t0, index);
+    e2k_gen_reg_write_i64(ctx, t0, index);
 
     tcg_temp_free_i64(t0);
 }
 
-static inline void gen_al_result_commit_reg(AlResult *res)
+static inline void gen_al_result_commit_reg128(DisasContext *ctx,
+    AlResult *res, int chan)
+{
+    Reg *index = &res->reg.index;
+
+    e2k_gen_reg_tag_write_i64(ctx, res->reg.tag, index);
+    if (res->vec) {
+        TCGv_vec t0 = tcg_temp_new_vec(TCG_TYPE_V128);
+
+        tcg_gen_ld_vec(t0, cpu_env, offsetof(CPUE2KState, al_q[chan]));
+        if (res->poison) {
+            gen_dst_poison_v128(t0, t0, res->reg.tag);
+        }
+        e2k_gen_qreg_write(ctx, t0, index);
+
+        tcg_temp_free_vec(t0);
+    } else {
+        TCGv_i64 t0 = tcg_temp_new_i64();
+        TCGv_i64 t1 = tcg_temp_new_i64();
+
+        if (res->poison) {
+            gen_dst_poison_i64(t0, res->reg.v64, res->reg.tag);
+            gen_dst_poison_i64(t1, res->reg.x64, res->reg.tag);
+        } else {
+            tcg_gen_mov_i64(t0, res->reg.v64);
+            tcg_gen_mov_i64(t1, res->reg.x64);
+        }
+        e2k_gen_reg_write_i64(ctx, t0, index);
+        e2k_gen_xreg_write_i64(ctx, t1, index);
+
+        tcg_temp_free_i64(t1);
+        tcg_temp_free_i64(t0);
+    }
+}
+
+static inline void gen_al_result_commit_reg(DisasContext *ctx,
+    AlResult *res)
 {
     AlResultType size = e2k_al_result_size(res->type);
 
@@ -4684,8 +5492,8 @@ static inline void gen_al_result_commit_reg(AlResult *res)
             /* wdbl is not set */
         }
 
-        gen_al_result_commit_reg32(res->poison, res->reg.index, res->reg.tag,
-            res->reg.v32);
+        gen_al_result_commit_reg32(ctx, res->poison, &res->reg.index,
+            res->reg.tag, res->reg.v32);
 
         if (res->dbl) {
             TCGv_i32 t0 = tcg_temp_new_i32();
@@ -4701,7 +5509,8 @@ static inline void gen_al_result_commit_reg(AlResult *res)
                 tcg_gen_mov_i32(t0, res->reg.tag);
             }
             tcg_gen_extu_i32_i64(t1, res->reg.v32);
-            gen_al_result_commit_reg64(res->poison, res->reg.index, t0, t1);
+            gen_al_result_commit_reg64(ctx, res->poison, &res->reg.index,
+                t0, t1);
 
             /* exit */
             gen_set_label(l1);
@@ -4712,18 +5521,16 @@ static inline void gen_al_result_commit_reg(AlResult *res)
         break;
     }
     case AL_RESULT_64:
-        gen_al_result_commit_reg64(res->poison, res->reg.index, res->reg.tag,
-            res->reg.v64);
+        gen_al_result_commit_reg64(ctx, res->poison, &res->reg.index,
+            res->reg.tag, res->reg.v64);
         break;
     case AL_RESULT_80:
-        gen_al_result_commit_reg64(res->poison, res->reg.index, res->reg.tag,
-            res->reg.v64);
-        e2k_gen_xreg_write16u_i32(res->reg.x32, res->reg.index);
+        gen_al_result_commit_reg64(ctx, res->poison, &res->reg.index,
+            res->reg.tag, res->reg.v64);
+        e2k_gen_xreg_write16u_i32(ctx, res->reg.x32, &res->reg.index);
         break;
     case AL_RESULT_128:
-        gen_al_result_commit_reg64(res->poison, res->reg.index, res->reg.tag,
-            res->reg.v64);
-        e2k_gen_xreg_write_i64(res->reg.x64, res->reg.index);
+        gen_al_result_commit_reg128(ctx, res, res - ctx->al_results);
         break;
     default:
         g_assert_not_reached();
@@ -4731,7 +5538,8 @@ static inline void gen_al_result_commit_reg(AlResult *res)
     }
 }
 
-static inline void gen_al_result_commit_ctpr(AlResult *res)
+static inline void gen_al_result_commit_ctpr(DisasContext *ctx,
+    AlResult *res)
 {
     AlResultType size = e2k_al_result_size(res->type);
     TCGv_i64 ctpr = e2k_cs.ctprs[res->ctpr.index];
@@ -4739,6 +5547,7 @@ static inline void gen_al_result_commit_ctpr(AlResult *res)
     TCGv_i64 t1 = tcg_const_i64(CTPR_TAG_DISP);
 
     assert(res->ctpr.index < 3);
+    ctx->ctprs[res->ctpr.index].raw = 0;
 
     switch (size) {
     case AL_RESULT_32:
@@ -4781,15 +5590,15 @@ void e2k_alc_commit(DisasContext *ctx)
             break;
         case AL_RESULT_REG:
             /* %rN, %b[N], %gN */
-            gen_al_result_commit_reg(res);
+            gen_al_result_commit_reg(ctx, res);
             break;
         case AL_RESULT_PREG:
             /* %predN */
-            e2k_gen_store_preg(res->preg.index, res->preg.val);
+            e2k_gen_store_preg(ctx, res->preg.index, res->preg.val);
             break;
         case AL_RESULT_CTPR:
             /* %ctprN */
-            gen_al_result_commit_ctpr(res);
+            gen_al_result_commit_ctpr(ctx, res);
             break;
         default:
             g_assert_not_reached();
@@ -4801,27 +5610,65 @@ void e2k_alc_commit(DisasContext *ctx)
 }
 
 
-void alc_init(DisasContext *ctx)
+static uint16_t alop_desc_ext(AlopDesc *desc, AlopKeyKind kind)
 {
-    int i, j;
+    switch (kind) {
+    case ALOP_KEY_OPCE1:
+    case ALOP_KEY_CMP:
+    case ALOP_KEY_CMP_C0:
+    case ALOP_KEY_OPCE3:
+    case ALOP_KEY_OPCE2:
+        return desc->extra1;
+    case ALOP_KEY_OPCE1_OPCE3:
+        return desc->extra1 << 8 | desc->extra2;
+    default:
+        return 0;
+    }
+}
 
-    memset(alops_map, -1, sizeof(alops_map));
-    memset(pfcomb_map, 0, sizeof(pfcomb_map));
+void alc_init(void)
+{
+    int i, j, v, count = 0;
 
-    // TODO: symmetric alops table
-    /* Most alops are symmetric and can be stored in a half table. */
+    memset(alops_kind, ALOP_KEY_UNUSED, sizeof(alops_kind));
+    memset(alops_hash, -1, sizeof(alops_hash));
+
+    /* Later entries of the alops table take precedence over earlier ones. */
     for (i = 0; i < ARRAY_SIZE(alops); i++) {
         AlopDesc *desc = &alops[i];
-        if (desc->min_version <= ctx->version && ctx->version <= desc->max_version) {
+        AlopKeyKind kind = alop_key_kind(desc);
+        uint16_t ext = alop_desc_ext(desc, kind);
+
+        if (kind == ALOP_KEY_UNUSED) {
+            continue;
+        }
+
+        for (v = desc->min_version; v < ALOP_VERSION_COUNT
+            && v <= desc->max_version; v++)
+        {
             for (j = 0; j < 6; j++) {
-                if (desc->channels & (1 << j)) {
-                    int16_t *p = &alops_map[desc->opc2][desc->opc1][j];
-                    desc->next[j] = *p;
-                    *p = i;
+                uint8_t *k = &alops_kind[v][desc->opc2][desc->opc1][j];
+                AlopHashEntry *e;
+
+                if (!(desc->channels & (1 << j))) {
+                    continue;
+                }
+
+                /* extension fields are never mixed within a slot */
+                assert(*k == ALOP_KEY_UNUSED || *k == kind);
+                *k = kind;
+
+                e = alop_hash_find(alop_key(v, desc->opc2, desc->opc1, j, ext));
+                if (e->key == ALOP_KEY_EMPTY) {
+                    /* keep the load factor low enough for short probes */
+                    count++;
+                    assert(count < ALOP_HASH_SIZE / 2);
+                    e->key = alop_key(v, desc->opc2, desc->opc1, j, ext);
                 }
+                e->index = i;
             }
         }
     }
 
-    pfcomb_init(ctx);
+    pfcomb_init();
 }
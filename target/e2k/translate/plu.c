@@ -27,16 +27,16 @@ void e2k_gen_cond_i32(DisasContext *ctx, TCGv_i32 ret, uint8_t psrc)
         int idx = extract8(psrc, 0, 5);
         if (psrc == 0) {
             // %lcntex
-            e2k_gen_lcntex(ret);
+            e2k_gen_lcntex(ctx, ret);
         } else if ((psrc & 0x40) == 0) {
             // %spredMASK
             e2k_todo_illop(ctx, "%%spred");
         } else if ((psrc & 0x60) == 0x60) {
             // %predN
-            e2k_gen_preg_i32(ret, idx);
+            e2k_gen_preg_i32(ctx, ret, idx);
         } else {
             // %pcntN
-            tcg_gen_setcondi_i32(TCG_COND_LEU, ret, e2k_cs.lsr_pcnt, idx);
+            e2k_gen_pcnt_i32(ctx, ret, idx);
         }
     }
 }
@@ -159,7 +159,7 @@ void e2k_plu_execute(DisasContext *ctx)
                     TCGv_i32 z = tcg_const_i32(0);
                     TCGv_i32 t0 = tcg_temp_new_i32();
 
-                    e2k_gen_preg_i32(t0, pdst);
+                    e2k_gen_preg_i32(ctx, t0, pdst);
                     tcg_gen_movcond_i32(TCG_COND_NE, ctx->pl_results[i].value,
                         p0, z, p1, t0);
 
@@ -190,6 +190,7 @@ void e2k_plu_commit(DisasContext *ctx)
         if (ctx->pl_results[i].reg < 0) {
             continue;
         }
-        e2k_gen_store_preg(ctx->pl_results[i].reg, ctx->pl_results[i].value);
+        e2k_gen_store_preg(ctx, ctx->pl_results[i].reg,
+            ctx->pl_results[i].value);
     }
 }
@@ -3,151 +3,150 @@
 #include "exec/log.h"
 #include "translate.h"
 
-static inline void gen_ptr_from_index(TCGv_ptr ret, TCGv_ptr ptr, TCGv_i32 idx,
-    int size)
+static inline void gen_preg_index(DisasContext *ctx, TCGv_i32 ret, int idx)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_ptr t1 = tcg_temp_new_ptr();
-
-    tcg_gen_muli_i32(t0, idx, size);
-    tcg_gen_ext_i32_ptr(t1, t0);
-    tcg_gen_add_ptr(ret, ptr, t1);
+    assert(idx < 32);
 
-    tcg_temp_free_ptr(t1);
-    tcg_temp_free_i32(t0);
+    if (idx <= ctx->psize) {
+        TCGv_i32 t0 = tcg_temp_new_i32();
+        TCGv_i32 t1 = tcg_temp_new_i32();
+        TCGv_i32 t2 = tcg_const_i32(ctx->psize + 1);
+
+        /* pcur <= psize, so a single conditional subtract wraps the index */
+        tcg_gen_addi_i32(t0, e2k_cs.pcur, idx);
+        tcg_gen_sub_i32(t1, t0, t2);
+        tcg_gen_movcond_i32(TCG_COND_GEU, ret, t0, t2, t1, t0);
+
+        tcg_temp_free_i32(t2);
+        tcg_temp_free_i32(t1);
+        tcg_temp_free_i32(t0);
+    } else {
+        tcg_gen_movi_i32(ret, idx);
+    }
 }
 
-static inline void gen_preg_index(TCGv_i32 ret, int idx)
+/*
+ * Returns the base pointer of a predicate in env, *offset is set to the
+ * offset from it. Static predicates are addressed directly from env.
+ */
+static TCGv_ptr gen_preg_ptr(DisasContext *ctx, int idx, int *offset)
 {
-    TCGv_i32 i = tcg_const_i32(idx);
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-    TCGv_i32 t2 = tcg_temp_new_i32();
-    TCGv_i32 t3 = tcg_temp_new_i32();
+    TCGv_ptr ret = tcg_temp_new_ptr();
 
-    assert(idx < 32);
+    if (idx <= ctx->psize) {
+        TCGv_i32 t0 = tcg_temp_new_i32();
 
-    tcg_gen_addi_i32(t0, e2k_cs.psize, 1);
-    tcg_gen_addi_i32(t1, e2k_cs.pcur, idx);
-    tcg_gen_remu_i32(t2, t1, t0);
-    tcg_gen_movi_i32(t3, idx);
-    tcg_gen_movcond_i32(TCG_COND_LEU, ret, i, e2k_cs.psize, t2, t3);
+        gen_preg_index(ctx, t0, idx);
+        tcg_gen_ext_i32_ptr(ret, t0);
+        tcg_gen_add_ptr(ret, cpu_env, ret);
+        *offset = offsetof(CPUE2KState, pregs);
 
-    tcg_temp_free_i32(t3);
-    tcg_temp_free_i32(t2);
-    tcg_temp_free_i32(t1);
-    tcg_temp_free_i32(t0);
-    tcg_temp_free_i32(i);
-}
-
-static void gen_preg_offset(TCGv_i64 ret, int idx)
-{
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-
-    gen_preg_index(t0, idx);
-    tcg_gen_muli_i32(t1, t0, 2);
-    tcg_gen_extu_i32_i64(ret, t1);
+        tcg_temp_free_i32(t0);
+    } else {
+        tcg_gen_addi_ptr(ret, cpu_env, 0);
+        *offset = offsetof(CPUE2KState, pregs[idx]);
+    }
 
-    tcg_temp_free_i32(t1);
-    tcg_temp_free_i32(t0);
+    return ret;
 }
 
-static void gen_preg_clear(TCGv_i64 ret, TCGv_i64 offset)
+void e2k_gen_preg_i32(DisasContext *ctx, TCGv_i32 ret, int reg)
 {
-    TCGv_i64 t0 = tcg_const_i64(3);
-    TCGv_i64 t1 = tcg_temp_new_i64();
-    TCGv_i64 t2 = tcg_temp_new_i64();
+    int offset;
+    TCGv_ptr t0 = gen_preg_ptr(ctx, reg, &offset);
 
-    tcg_gen_shl_i64(t1, t0, offset);
-    tcg_gen_not_i64(t2, t1);
-    tcg_gen_and_i64(ret, t2, e2k_cs.pregs);
+    tcg_gen_ld8u_i32(ret, t0, offset);
+    tcg_gen_andi_i32(ret, ret, 1);
 
-    tcg_temp_free_i64(t2);
-    tcg_temp_free_i64(t1);
-    tcg_temp_free_i64(t0);
-}
-
-static inline void gen_preg_i64(TCGv_i64 ret, int reg)
-{
-    TCGv_i64 one = tcg_const_i64(1);
-    TCGv_i64 t0 = tcg_temp_new_i64();
-    TCGv_i64 t1 = tcg_temp_new_i64();
-    TCGv_i64 t2 = tcg_temp_new_i64();
-
-    gen_preg_offset(t0, reg);
-    tcg_gen_shl_i64(t1, one, t0);
-    tcg_gen_and_i64(t2, e2k_cs.pregs, t1);
-    tcg_gen_setcondi_i64(TCG_COND_NE, ret, t2, 0);
-
-    tcg_temp_free_i64(t2);
-    tcg_temp_free_i64(t1);
-    tcg_temp_free_i64(t0);
-    tcg_temp_free_i64(one);
+    tcg_temp_free_ptr(t0);
 }
 
-void e2k_gen_preg_i32(TCGv_i32 ret, int reg)
+void e2k_gen_store_preg(DisasContext *ctx, int idx, TCGv_i32 val)
 {
-    TCGv_i64 t0 = tcg_temp_new_i64();
+    int offset;
+    TCGv_ptr t0 = gen_preg_ptr(ctx, idx, &offset);
 
-    gen_preg_i64(t0, reg);
-    tcg_gen_extrl_i64_i32(ret, t0);
-    tcg_temp_free_i64(t0);
-}
+    tcg_gen_st8_i32(val, t0, offset);
 
-void e2k_gen_store_preg(int idx, TCGv_i32 val)
-{
-    TCGv_i64 t0 = tcg_temp_new_i64();
-    TCGv_i64 t1 = tcg_temp_new_i64();
-    TCGv_i64 t2 = tcg_temp_new_i64();
-    TCGv_i64 t3 = tcg_temp_new_i64();
-    TCGv_i64 t4 = tcg_temp_new_i64();
-
-    gen_preg_offset(t0, idx);
-    gen_preg_clear(t1, t0);
-    tcg_gen_extu_i32_i64(t2, val);
-    tcg_gen_andi_i64(t3, t2, 3);
-    tcg_gen_shl_i64(t4, t2, t0);
-    tcg_gen_or_i64(e2k_cs.pregs, t1, t4);
-
-    tcg_temp_free_i64(t4);
-    tcg_temp_free_i64(t3);
-    tcg_temp_free_i64(t2);
-    tcg_temp_free_i64(t1);
-    tcg_temp_free_i64(t0);
+    tcg_temp_free_ptr(t0);
 }
 
-static inline void gen_reg_tag_ptr(TCGv_ptr ret, TCGv_i32 idx)
+/*
+ * Returns the base pointer of a register slot in an env array with elements
+ * of the given size, *offset is set to the slot offset from the array start.
+ */
+static TCGv_ptr gen_reg_ptr(DisasContext *ctx, Reg *reg, int size,
+    int *offset)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-    TCGv_ptr t1 = tcg_temp_new_ptr();
-
-    tcg_gen_ext_i32_ptr(t0, idx);
-    tcg_gen_addi_ptr(t1, cpu_env, offsetof(CPUE2KState, tags));
-    tcg_gen_add_ptr(ret, t1, t0);
+    TCGv_ptr ret = tcg_temp_new_ptr();
+    TCGv_ptr window = size == 1 ? ctx->wtags : ctx->wregs;
+
+    switch (reg->kind) {
+    case REG_WINDOW:
+        /* keep the offset static so it folds into the memory access */
+        tcg_gen_addi_ptr(ret, window, 0);
+        *offset = reg->n * size;
+        break;
+    case REG_BASED: {
+        TCGv_i32 t0 = tcg_temp_new_i32();
+
+        tcg_gen_muli_i32(t0, reg->off, size);
+        tcg_gen_ext_i32_ptr(ret, t0);
+        tcg_gen_add_ptr(ret, window, ret);
+        *offset = 0;
+
+        tcg_temp_free_i32(t0);
+        break;
+    }
+    case REG_GLOBAL:
+        tcg_gen_addi_ptr(ret, cpu_env, 0);
+        *offset = (E2K_GR_BASE + reg->n) * size;
+        break;
+    default:
+        g_assert_not_reached();
+        break;
+    }
 
-    tcg_temp_free_ptr(t1);
-    tcg_temp_free_ptr(t0);
+    return ret;
 }
 
-void e2k_gen_reg_tag_read_i64(TCGv_i32 ret, TCGv_i32 idx)
-{
-    TCGv_ptr t0 = tcg_temp_new_ptr();
+#define GEN_REG_ACCESS(name, ty, array, field, op) \
+    static void name(DisasContext *ctx, ty val, Reg *reg) \
+    { \
+        int offset; \
+        TCGv_ptr t0 = gen_reg_ptr(ctx, reg, \
+            sizeof_field(CPUE2KState, array[0]), &offset); \
+        op(val, t0, offsetof(CPUE2KState, array[0] field) + offset); \
+        tcg_temp_free_ptr(t0); \
+    }
 
-    gen_reg_tag_ptr(t0, idx);
-    tcg_gen_ld8u_i32(ret, t0, 0);
-    tcg_temp_free_ptr(t0);
+GEN_REG_ACCESS(gen_tag_ld8u, TCGv_i32, tags, , tcg_gen_ld8u_i32)
+GEN_REG_ACCESS(gen_tag_st8, TCGv_i32, tags, , tcg_gen_st8_i32)
+GEN_REG_ACCESS(gen_reg_ld_i64, TCGv_i64, regs, .lo, tcg_gen_ld_i64)
+GEN_REG_ACCESS(gen_reg_ld_i32, TCGv_i32, regs, .lo, tcg_gen_ld_i32)
+GEN_REG_ACCESS(gen_reg_st_i64, TCGv_i64, regs, .lo, tcg_gen_st_i64)
+GEN_REG_ACCESS(gen_reg_st_i32, TCGv_i32, regs, .lo, tcg_gen_st_i32)
+GEN_REG_ACCESS(gen_xreg_ld_i64, TCGv_i64, regs, .hi, tcg_gen_ld_i64)
+GEN_REG_ACCESS(gen_xreg_ld_i32, TCGv_i32, regs, .hi, tcg_gen_ld_i32)
+GEN_REG_ACCESS(gen_xreg_ld16u_i32, TCGv_i32, regs, .hi, tcg_gen_ld16u_i32)
+GEN_REG_ACCESS(gen_xreg_st_i64, TCGv_i64, regs, .hi, tcg_gen_st_i64)
+GEN_REG_ACCESS(gen_xreg_st_i32, TCGv_i32, regs, .hi, tcg_gen_st_i32)
+GEN_REG_ACCESS(gen_xreg_st16_i32, TCGv_i32, regs, .hi, tcg_gen_st16_i32)
+GEN_REG_ACCESS(gen_qreg_ld_vec, TCGv_vec, regs, , tcg_gen_ld_vec)
+GEN_REG_ACCESS(gen_qreg_st_vec, TCGv_vec, regs, , tcg_gen_st_vec)
+
+void e2k_gen_reg_tag_read_i64(DisasContext *ctx, TCGv_i32 ret, Reg *reg)
+{
+    gen_tag_ld8u(ctx, ret, reg);
 }
 
-void e2k_gen_reg_tag_read_i32(TCGv_i32 ret, TCGv_i32 idx)
+void e2k_gen_reg_tag_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
-    TCGv_i32 t1 = tcg_temp_new_i32();
+    TCGv_i32 t0 = tcg_temp_new_i32();
 
-    gen_reg_tag_ptr(t0, idx);
-    tcg_gen_ld8u_i32(t1, t0, 0);
-    tcg_gen_andi_i32(ret, t1, GEN_MASK(0, E2K_TAG_SIZE));
-    tcg_temp_free_ptr(t0);
+    gen_tag_ld8u(ctx, t0, reg);
+    tcg_gen_andi_i32(ret, t0, GEN_MASK(0, E2K_TAG_SIZE));
+    tcg_temp_free_i32(t0);
 }
 
 static inline void gen_tag_check(TCGv_i32 ret, TCGv_i32 tag)
@@ -170,106 +169,143 @@ void e2k_gen_reg_tag_check_i32(TCGv_i32 ret, TCGv_i32 tag)
     tcg_temp_free_i32(t0);
 }
 
-void e2k_gen_reg_tag_write_i64(TCGv_i32 value, TCGv_i32 idx)
+void e2k_gen_reg_tag_write_i64(DisasContext *ctx, TCGv_i32 value, Reg *reg)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
+    gen_tag_st8(ctx, value, reg);
+}
 
-    gen_reg_tag_ptr(t0, idx);
-    tcg_gen_st8_i32(value, t0, 0);
-    tcg_temp_free_ptr(t0);
+void e2k_gen_reg_tag_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg)
+{
+    TCGv_i32 t0 = tcg_temp_new_i32();
+
+    gen_tag_ld8u(ctx, t0, reg);
+    tcg_gen_deposit_i32(t0, t0, value, 0, E2K_TAG_SIZE);
+    gen_tag_st8(ctx, t0, reg);
+
+    tcg_temp_free_i32(t0);
+}
+
+void e2k_gen_reg_index_from_wregi(Reg *ret, int idx)
+{
+    ret->kind = REG_WINDOW;
+    ret->n = idx;
 }
 
-void e2k_gen_reg_tag_write_i32(TCGv_i32 value, TCGv_i32 idx)
+void e2k_gen_reg_index_from_bregi(DisasContext *ctx, Reg *ret, int idx)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
+    TCGv_i32 t0 = tcg_temp_new_i32();
     TCGv_i32 t1 = tcg_temp_new_i32();
-    TCGv_i32 t2 = tcg_temp_new_i32();
+    TCGv_i32 t2 = tcg_const_i32(ctx->bsize);
 
-    gen_reg_tag_ptr(t0, idx);
-    tcg_gen_ld8u_i32(t1, t0, 0);
-    tcg_gen_deposit_i32(t2, t1, value, 0, E2K_TAG_SIZE);
-    tcg_gen_st8_i32(t2, t0, 0);
+    /* bcur < bsize and idx < bsize (see do_checks), so bcur + idx wraps
+     * at most once */
+    tcg_gen_addi_i32(t0, e2k_cs.bcur, idx);
+    tcg_gen_sub_i32(t1, t0, t2);
+    tcg_gen_movcond_i32(TCG_COND_GEU, t0, t0, t2, t1, t0);
+    tcg_gen_addi_i32(ret->off, t0, ctx->boff);
+    ret->kind = REG_BASED;
 
     tcg_temp_free_i32(t2);
     tcg_temp_free_i32(t1);
-    tcg_temp_free_ptr(t0);
+    tcg_temp_free_i32(t0);
 }
 
-static inline void gen_reg_index_from_wreg(TCGv_i32 ret, TCGv_i32 idx)
+void e2k_gen_reg_index_from_gregi(Reg *ret, int idx)
 {
-    tcg_gen_mov_i32(ret, idx);
+    // TODO: based global registers index
+    ret->kind = REG_GLOBAL;
+    ret->n = idx;
 }
 
-void e2k_gen_reg_index_from_wregi(TCGv_i32 ret, int idx)
+void e2k_gen_reg_read_i64(DisasContext *ctx, TCGv_i64 ret, Reg *reg)
 {
-    tcg_gen_movi_i32(ret, idx);
+    if (reg->kind == REG_GLOBAL) {
+        tcg_gen_mov_i64(ret, e2k_cs.gregs[reg->n]);
+    } else {
+        gen_reg_ld_i64(ctx, ret, reg);
+    }
 }
 
-void e2k_gen_reg_index_from_bregi(TCGv_i32 ret, int idx)
+void e2k_gen_reg_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg)
 {
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-    TCGv_i32 t2 = tcg_temp_new_i32();
+    if (reg->kind == REG_GLOBAL) {
+        tcg_gen_extrl_i64_i32(ret, e2k_cs.gregs[reg->n]);
+    } else {
+        gen_reg_ld_i32(ctx, ret, reg);
+    }
+}
 
-    tcg_gen_addi_i32(t0, e2k_cs.bcur, idx);
-    tcg_gen_remu_i32(t1, t0, e2k_cs.bsize);
-    tcg_temp_free_i32(t0);
-    tcg_gen_add_i32(t2, e2k_cs.boff, t1);
-    tcg_temp_free_i32(t1);
-    gen_reg_index_from_wreg(ret, t2);
-    tcg_temp_free_i32(t2);
+void e2k_gen_reg_write_i64(DisasContext *ctx, TCGv_i64 value, Reg *reg)
+{
+    if (reg->kind == REG_GLOBAL) {
+        tcg_gen_mov_i64(e2k_cs.gregs[reg->n], value);
+    } else {
+        gen_reg_st_i64(ctx, value, reg);
+    }
 }
 
-void e2k_gen_reg_index_from_gregi(TCGv_i32 ret, int idx)
+void e2k_gen_reg_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg)
 {
-    // TODO: based global registers index
-    tcg_gen_movi_i32(ret, E2K_NR_COUNT + idx);
+    if (reg->kind == REG_GLOBAL) {
+        TCGv_i64 t0 = tcg_temp_new_i64();
+        TCGv_i64 greg = e2k_cs.gregs[reg->n];
+
+        tcg_gen_extu_i32_i64(t0, value);
+        tcg_gen_deposit_i64(greg, greg, t0, 0, 32);
+        tcg_temp_free_i64(t0);
+    } else {
+        gen_reg_st_i32(ctx, value, reg);
+    }
 }
 
-static inline void gen_reg_ptr(TCGv_ptr ret, TCGv_i32 idx)
+void e2k_gen_xreg_read_i64(DisasContext *ctx, TCGv_i64 ret, Reg *reg)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
+    gen_xreg_ld_i64(ctx, ret, reg);
+}
 
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, regs));
-    gen_ptr_from_index(ret, t0, idx, 8);
-    tcg_temp_free_ptr(t0);
+void e2k_gen_xreg_read_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg)
+{
+    gen_xreg_ld_i32(ctx, ret, reg);
 }
 
-static inline void gen_xreg_ptr(TCGv_ptr ret, TCGv_i32 idx)
+void e2k_gen_xreg_read16u_i32(DisasContext *ctx, TCGv_i32 ret, Reg *reg)
 {
-    TCGv_ptr t0 = tcg_temp_new_ptr();
+    gen_xreg_ld16u_i32(ctx, ret, reg);
+}
 
-    tcg_gen_addi_ptr(t0, cpu_env, offsetof(CPUE2KState, xregs));
-    gen_ptr_from_index(ret, t0, idx, 8);
-    tcg_temp_free_ptr(t0);
+void e2k_gen_xreg_write_i64(DisasContext *ctx, TCGv_i64 value, Reg *reg)
+{
+    gen_xreg_st_i64(ctx, value, reg);
 }
 
-#define GEN_REG_READ(name, ty, ptr_func, ld_func) \
-    void name(ty ret, TCGv_i32 idx) \
-    { \
-        TCGv_ptr t0 = tcg_temp_new_ptr(); \
-        ptr_func(t0, idx); \
-        ld_func(ret, t0, 0); \
-        tcg_temp_free_ptr(t0); \
-    }
+void e2k_gen_xreg_write_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg)
+{
+    gen_xreg_st_i32(ctx, value, reg);
+}
 
-#define GEN_REG_WRITE(name, ty, ptr_func, st_func) \
-    void name(ty value, TCGv_i32 idx) \
-    { \
-        TCGv_ptr t0 = tcg_temp_new_ptr(); \
-        ptr_func(t0, idx); \
-        st_func(value, t0, 0); \
-        tcg_temp_free_ptr(t0); \
+void e2k_gen_xreg_write16u_i32(DisasContext *ctx, TCGv_i32 value, Reg *reg)
+{
+    gen_xreg_st16_i32(ctx, value, reg);
+}
+
+/*
+ * The low half of %gN lives in a TCG global, write it back before the whole
+ * register is loaded from env and reload it after the register is stored.
+ */
+void e2k_gen_qreg_read(DisasContext *ctx, TCGv_vec ret, Reg *reg)
+{
+    if (reg->kind == REG_GLOBAL) {
+        tcg_gen_st_i64(e2k_cs.gregs[reg->n], cpu_env,
+            offsetof(CPUE2KState, regs[E2K_GR_BASE + reg->n].lo));
     }
+    gen_qreg_ld_vec(ctx, ret, reg);
+}
 
-GEN_REG_READ(e2k_gen_reg_read_i64, TCGv_i64, gen_reg_ptr, tcg_gen_ld_i64)
-GEN_REG_READ(e2k_gen_reg_read_i32, TCGv_i32, gen_reg_ptr, tcg_gen_ld_i32)
-GEN_REG_WRITE(e2k_gen_reg_write_i64, TCGv_i64, gen_reg_ptr, tcg_gen_st_i64)
-GEN_REG_WRITE(e2k_gen_reg_write_i32, TCGv_i32, gen_reg_ptr, tcg_gen_st_i32)
-
-GEN_REG_READ(e2k_gen_xreg_read_i64, TCGv_i64, gen_xreg_ptr, tcg_gen_ld_i64)
-GEN_REG_READ(e2k_gen_xreg_read_i32, TCGv_i32, gen_xreg_ptr, tcg_gen_ld_i32)
-GEN_REG_READ(e2k_gen_xreg_read16u_i32, TCGv_i32, gen_xreg_ptr, tcg_gen_ld16u_i32)
-GEN_REG_WRITE(e2k_gen_xreg_write_i64, TCGv_i64, gen_xreg_ptr, tcg_gen_st_i64)
-GEN_REG_WRITE(e2k_gen_xreg_write_i32, TCGv_i32, gen_xreg_ptr, tcg_gen_st_i32)
-GEN_REG_WRITE(e2k_gen_xreg_write16u_i32, TCGv_i32, gen_xreg_ptr, tcg_gen_st16_i32)
+void e2k_gen_qreg_write(DisasContext *ctx, TCGv_vec value, Reg *reg)
+{
+    gen_qreg_st_vec(ctx, value, reg);
+    if (reg->kind == REG_GLOBAL) {
+        tcg_gen_ld_i64(e2k_cs.gregs[reg->n], cpu_env,
+            offsetof(CPUE2KState, regs[E2K_GR_BASE + reg->n].lo));
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Microbenchmark for the packed shuffle and bit logic ops: pshufb, pmerge
+ * and the three input logic of SHA-2 style rounds, which the compiler turns
+ * into plog on elbrus-v5 and later. Run it under time(1) to compare builds,
+ * the printed checksum must not change between them.
+ */
+#include <asm/e2k_api.h>
+#include <asm/unistd.h>
+
+#ifndef ITERS
+#define ITERS (1 << 22)
+#endif
+
+static void put_hex(unsigned long long x)
+{
+	char buf[17];
+	int i;
+
+	for (i = 15; i >= 0; i--) {
+		buf[i] = "0123456789abcdef"[x & 0xf];
+		x >>= 4;
+	}
+	buf[16] = '\n';
+	__E2K_SYSCALL_3(LINUX_SYSCALL64_TRAPNUM, __NR_write, 1, buf, sizeof(buf));
+}
+
+void _start(void) {
+	unsigned long long a = 0x0123456789abcdefULL;
+	unsigned long long b = 0xfedcba9876543210ULL;
+	unsigned long long c = 0x0f1e2d3c4b5a6978ULL;
+	unsigned long long sum = 0;
+	long i;
+
+	for (i = 0; i < ITERS; i++) {
+		unsigned long long x = __builtin_e2k_pshufb(a, b, c);
+		unsigned long long y = __builtin_e2k_pmerge(a, b, x);
+		unsigned long long ch = (x & y) ^ (~x & c);
+		unsigned long long maj = (a & b) ^ (a & c) ^ (b & c);
+
+		sum += ch ^ maj;
+		a = b + ch;
+		b = c ^ maj;
+		c = x + y + sum;
+	}
+
+	put_hex(sum);
+	__E2K_SYSCALL_1(LINUX_SYSCALL64_TRAPNUM, __NR_exit, 0);
+}
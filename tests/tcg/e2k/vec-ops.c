@@ -0,0 +1,111 @@
+/*
+ * Checks pshufb, pmerge and plog against known results. The pshufb
+ * descriptors cover every mode of the descriptor byte: plain index into
+ * either source, bit reverse, msb and lsb repeat, invert on its own and
+ * combined with the others, and the four constants.
+ */
+#include <asm/e2k_api.h>
+#include <asm/unistd.h>
+
+#define SRC1 0x0123456789abcdefULL
+#define SRC2 0xf0e1d2c3b4a59687ULL
+#define SRC3 0x5a5aa5a5ff00f00fULL
+
+/* keep the compiler from folding the ops away */
+static volatile unsigned long long src[3] = { SRC1, SRC2, SRC3 };
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+struct vec {
+	unsigned long long src, res;
+};
+
+static const struct vec pshufb_vecs[] = {
+	{ 0x0001020304050607ULL, 0x8796a5b4c3d2e1f0ULL }, /* src2 */
+	{ 0x0f0e0d0c0b0a0908ULL, 0x0123456789abcdefULL }, /* src1 */
+	{ 0x2028212922aa2b23ULL, 0xe1f769b3a57f912dULL }, /* reverse */
+	{ 0x484f4c4b4a414e40ULL, 0xff0000ffffff00ffULL }, /* msb */
+	{ 0x606f686761696e66ULL, 0xffffff0000ffffffULL }, /* lsb */
+	{ 0x101f181711191e16ULL, 0x78fe100f6932dc1eULL }, /* invert */
+	{ 0x303c787d5f5a3b36ULL, 0x1e190000ff006e78ULL }, /* invert+ */
+	{ 0x80a0c0e09fbfdfffULL, 0x007f80ff007f80ffULL }, /* constants */
+};
+
+static const struct vec pmerge_vecs[] = {
+	{ 0x0000000000000000ULL, 0x0123456789abcdefULL },
+	{ 0x8080808080808080ULL, 0xf0e1d2c3b4a59687ULL },
+	{ 0xff007f8001fe80c0ULL, 0xf02345c389a59687ULL },
+};
+
+static void put_str(const char *s)
+{
+	unsigned long n = 0;
+
+	while (s[n]) {
+		n++;
+	}
+	__E2K_SYSCALL_3(LINUX_SYSCALL64_TRAPNUM, __NR_write, 1, s, n);
+}
+
+static void put_hex(unsigned long long x)
+{
+	char buf[17];
+	int i;
+
+	for (i = 15; i >= 0; i--) {
+		buf[i] = "0123456789abcdef"[x & 0xf];
+		x >>= 4;
+	}
+	buf[16] = 0;
+	put_str(buf);
+}
+
+static int check(const char *name, unsigned long long res,
+                 unsigned long long expected)
+{
+	if (res == expected) {
+		return 0;
+	}
+
+	put_str(name);
+	put_str(": got ");
+	put_hex(res);
+	put_str(", expected ");
+	put_hex(expected);
+	put_str("\n");
+	return 1;
+}
+
+#define CHECK_PLOG(table, expected) \
+	check("plog " #table, __builtin_e2k_plog(table, s1, s2, s3), \
+	      expected)
+
+void _start(void) {
+	unsigned long long s1 = src[0], s2 = src[1], s3 = src[2];
+	int err = 0;
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(pshufb_vecs); i++) {
+		err |= check("pshufb", __builtin_e2k_pshufb(s1, s2,
+		             pshufb_vecs[i].src), pshufb_vecs[i].res);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pmerge_vecs); i++) {
+		err |= check("pmerge", __builtin_e2k_pmerge(s1, s2,
+		             pmerge_vecs[i].src), pmerge_vecs[i].res);
+	}
+
+	err |= CHECK_PLOG(0x00, 0x0000000000000000ULL);
+	err |= CHECK_PLOG(0xff, 0xffffffffffffffffULL);
+	err |= CHECK_PLOG(0xf0, 0x0123456789abcdefULL);
+	err |= CHECK_PLOG(0xcc, 0xf0e1d2c3b4a59687ULL);
+	err |= CHECK_PLOG(0xaa, 0x5a5aa5a5ff00f00fULL);
+	err |= CHECK_PLOG(0x80, 0x0000000180008007ULL);
+	err |= CHECK_PLOG(0x96, 0xab983201c20eab67ULL);
+	err |= CHECK_PLOG(0xe8, 0x5063c5e7bda1d48fULL);
+	err |= CHECK_PLOG(0xca, 0x5a79e0c3f6a1b487ULL);
+	err |= CHECK_PLOG(0x1e, 0xfbd8b280760e3b60ULL);
+	err |= CHECK_PLOG(0x6b, 0x5e7fedfe7ff17498ULL);
+
+	__E2K_SYSCALL_1(LINUX_SYSCALL64_TRAPNUM, __NR_exit, err);
+}